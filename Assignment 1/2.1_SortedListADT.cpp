@@ -4,10 +4,294 @@
 //
 
 #include <iostream>
+#include <iomanip>
+#include <climits>
 #include <string>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cmath>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <chrono>
+#include <new>
+#include <cstdlib>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 using namespace std;
 
+/*
+ * Output of pair keys, e.g. pair<double, string> (used by indexOf messages).
+ */
+template <typename T1, typename T2>
+ostream& operator<<(ostream& out, const pair<T1, T2>& item) {
+    return out << "(" << item.first << ", " << item.second << ")";
+}
+
+/* ==== Shared code (allocation resources) ====
+ * Byte-identical copy of the one in 2.3_AccountingForACafe.cpp: each program is submitted as one file. */
+
+/*
+ * Counters of an allocation resource.
+ */
+struct AllocationStats {
+    long long bytesInUse = 0; // bytes given to the containers and not deallocated yet
+    long long peakBytesInUse = 0; // maximum of bytesInUse
+    long long allocationCalls = 0; // number of allocate calls
+    long long systemAllocations = 0; // number of blocks requested from operator new
+
+    void onAllocate(size_t bytes) {
+        bytesInUse += bytes;
+        allocationCalls++;
+        if (bytesInUse > peakBytesInUse)
+            peakBytesInUse = bytesInUse;
+    }
+
+    void onDeallocate(size_t bytes) {
+        bytesInUse -= bytes;
+    }
+};
+
+/*
+ * Bump (arena) allocation resource.
+ *
+ * Memory is cut from big blocks just by moving a pointer. Deallocate does not
+ * give the memory back, it only updates the counters. The whole arena is reused
+ * at once with reset(), which rewinds to the first block in O(1): the blocks are
+ * kept for the next batch and returned to the system only in the destructor.
+ */
+class Arena {
+private:
+    struct Block {
+        Block* next;
+        size_t size; // number of bytes after the header
+    };
+
+    Block* first; // the chain of all blocks
+    Block* current; // block we cut from
+    char* position; // first free byte of the current block
+    char* end; // end of the current block
+    size_t blockSize; // size of a new block (bigger requests get a block of their own size)
+    AllocationStats stats;
+
+    static char* data(Block* block) {
+        return (char*) (block + 1);
+    }
+
+    void use(Block* block) {
+        current = block;
+        position = data(block);
+        end = position + block->size;
+    }
+
+public:
+    explicit Arena(size_t blockSize = 1 << 16) : first(nullptr), current(nullptr), position(nullptr), end(nullptr), blockSize(blockSize) {}
+
+    ~Arena() {
+        while (first != nullptr) {
+            Block* next = first->next;
+            ::operator delete(first);
+            first = next;
+        }
+    }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /*
+     * Time complexity: O(1) amortized
+     * Align the position, take the next block if the current one is over.
+     */
+    void* allocate(size_t bytes, size_t alignment) {
+        stats.onAllocate(bytes);
+
+        char* aligned = (char*) (((size_t) position + alignment - 1) & ~(alignment - 1));
+        while (current == nullptr || aligned + bytes > end) {
+            if (current != nullptr && current->next != nullptr && current->next->size >= bytes + alignment) {
+                use(current->next); // block left from the previous batch
+            } else {
+                size_t size = max(blockSize, bytes + alignment);
+                Block* block = (Block*) ::operator new(sizeof(Block) + size);
+                block->size = size;
+                stats.systemAllocations++;
+
+                if (current == nullptr) {
+                    block->next = first;
+                    first = block;
+                } else {
+                    block->next = current->next;
+                    current->next = block;
+                }
+                use(block);
+            }
+            aligned = (char*) (((size_t) position + alignment - 1) & ~(alignment - 1));
+        }
+
+        position = aligned + bytes;
+        return aligned;
+    }
+
+    // Time complexity: O(1). Memory is reused only after reset
+    void deallocate(void*, size_t bytes, size_t) {
+        stats.onDeallocate(bytes);
+    }
+
+    /*
+     * Time complexity: O(1)
+     * Forget everything allocated from the arena. Containers which use it
+     * must be destroyed (or never touched again) before that.
+     */
+    void reset() {
+        if (first != nullptr)
+            use(first);
+        stats.bytesInUse = 0;
+    }
+
+    const AllocationStats& statistics() const {
+        return stats;
+    }
+};
+
+/*
+ * Size-class pool allocation resource.
+ *
+ * Requests up to maxPooledSize bytes are rounded up to a power of two (size class).
+ * Every size class keeps a free list of the returned chunks, so a chunk is reused
+ * by the next request of the same class. New chunks are cut from slabs of an Arena.
+ * Bigger requests and requests aligned stronger than a size class go straight to the
+ * aligned operator new, and deallocate returns them to the aligned operator delete.
+ */
+class Pool {
+private:
+    static const int minClassSize = 16;
+    static const int numberOfClasses = 9; // 16, 32, ..., 4096 bytes
+    static const size_t maxPooledSize = minClassSize << (numberOfClasses - 1);
+
+    struct FreeChunk {
+        FreeChunk* next;
+    };
+
+    FreeChunk* freeLists[numberOfClasses];
+    Arena slabs;
+    AllocationStats stats;
+
+    // Whether the chunk comes from a size class (otherwise from operator new)
+    static bool isPooled(size_t bytes, size_t alignment) {
+        return bytes <= maxPooledSize && alignment <= minClassSize;
+    }
+
+    static int sizeClass(size_t bytes) {
+        int sizeClass = 0;
+        while ((size_t) (minClassSize << sizeClass) < bytes)
+            sizeClass++;
+        return sizeClass;
+    }
+
+public:
+    Pool() : slabs(1 << 16) {
+        for (int id = 0; id < numberOfClasses; ++id)
+            freeLists[id] = nullptr;
+    }
+
+    Pool(const Pool&) = delete;
+    Pool& operator=(const Pool&) = delete;
+
+    // Time complexity: O(1) amortized
+    void* allocate(size_t bytes, size_t alignment) {
+        stats.onAllocate(bytes);
+        if (!isPooled(bytes, alignment)) {
+            stats.systemAllocations++;
+            return ::operator new(bytes, align_val_t(alignment));
+        }
+
+        int id = sizeClass(bytes);
+        if (freeLists[id] != nullptr) {
+            FreeChunk* chunk = freeLists[id];
+            freeLists[id] = chunk->next;
+            return chunk;
+        }
+
+        size_t before = slabs.statistics().systemAllocations;
+        void* chunk = slabs.allocate(minClassSize << id, minClassSize);
+        stats.systemAllocations += slabs.statistics().systemAllocations - before;
+        return chunk;
+    }
+
+    // Time complexity: O(1). The chunk goes to the free list of its size class
+    void deallocate(void* pointer, size_t bytes, size_t alignment) {
+        stats.onDeallocate(bytes);
+        if (!isPooled(bytes, alignment)) {
+            ::operator delete(pointer, align_val_t(alignment));
+            return;
+        }
+
+        FreeChunk* chunk = (FreeChunk*) pointer;
+        int id = sizeClass(bytes);
+        chunk->next = freeLists[id];
+        freeLists[id] = chunk;
+    }
+
+    const AllocationStats& statistics() const {
+        return stats;
+    }
+};
+
+/*
+ * Allocator which takes memory from a resource (Arena or Pool).
+ * Copies of the allocator share the resource, so all the containers
+ * created with it (and their rebound allocators) use the same memory.
+ */
+template <typename T, typename Resource>
+class ResourceAllocator {
+public:
+    typedef T value_type;
+    typedef true_type propagate_on_container_copy_assignment;
+    typedef true_type propagate_on_container_move_assignment;
+    typedef true_type propagate_on_container_swap;
+
+    Resource* resource;
+
+    explicit ResourceAllocator(Resource* resource) : resource(resource) {}
+
+    template <typename U>
+    ResourceAllocator(const ResourceAllocator<U, Resource>& other) : resource(other.resource) {}
+
+    T* allocate(size_t n) {
+        return (T*) resource->allocate(n * sizeof(T), alignof(T));
+    }
+
+    void deallocate(T* pointer, size_t n) {
+        resource->deallocate(pointer, n * sizeof(T), alignof(T));
+    }
+
+    template <typename U>
+    bool operator==(const ResourceAllocator<U, Resource>& other) const {
+        return resource == other.resource;
+    }
+
+    template <typename U>
+    bool operator!=(const ResourceAllocator<U, Resource>& other) const {
+        return resource != other.resource;
+    }
+};
+
+template <typename T>
+using ArenaAllocator = ResourceAllocator<T, Arena>;
+
+template <typename T>
+using PoolAllocator = ResourceAllocator<T, Pool>;
+
+/* ==== End of shared code (allocation resources) ==== */
+
 template <typename T>
 class ListADT {
     virtual void push(T item) = 0; // add a new item to the List
@@ -16,33 +300,96 @@ class ListADT {
     virtual void print() = 0; // output all items of the List to console
 };
 
-template <typename T>
+template <typename T, typename Alloc = allocator<T>>
 class List : ListADT<T> {
 private:
+    typedef allocator_traits<Alloc> Traits;
+
+    Alloc alloc; // gives raw memory, the elements are constructed only when pushed
     T* arr;
     int arraySize;
     int numberOfElements;
+
+    /*
+     * Time complexity O(N) worst case
+     * Move the elements into raw storage of the new size.
+     * Slots after the elements stay not constructed.
+     */
+    void reallocate(int newSize) {
+        T* tempArr = Traits::allocate(alloc, newSize);
+
+        for (int i = 0; i < numberOfElements; ++i) {
+            Traits::construct(alloc, tempArr + i, std::move(arr[i]));
+            Traits::destroy(alloc, arr + i);
+        }
+
+        if (arr != nullptr)
+            Traits::deallocate(alloc, arr, arraySize);
+        arraySize = newSize;
+        arr = tempArr;
+    }
 public:
-    List() {
-        arr = new T[1];
-        arraySize = 1;
+    explicit List(const Alloc& alloc = Alloc()) : alloc(alloc) {
+        arr = nullptr;
+        arraySize = 0;
         numberOfElements = 0;
     }
-    // Time complexity O(N) worst case
-    void push(T item) {
-        if (numberOfElements == arraySize) {
-            T* tempArr = new T[arraySize * 2];
 
-            for (int i = 0; i < numberOfElements; ++i)
-                tempArr[i] = arr[i];
+    List(const List& other) : List(Traits::select_on_container_copy_construction(other.alloc)) {
+        reserve(other.numberOfElements);
+        for (int i = 0; i < other.numberOfElements; ++i)
+            Traits::construct(alloc, arr + i, other.arr[i]);
+        numberOfElements = other.numberOfElements;
+    }
+
+    List(List&& other) noexcept : List(other.alloc) {
+        std::swap(arr, other.arr);
+        std::swap(arraySize, other.arraySize);
+        std::swap(numberOfElements, other.numberOfElements);
+    }
+
+    // Both copy and move assignment: other is already a copy (or moved) List
+    List& operator=(List other) {
+        std::swap(alloc, other.alloc);
+        std::swap(arr, other.arr);
+        std::swap(arraySize, other.arraySize);
+        std::swap(numberOfElements, other.numberOfElements);
+        return *this;
+    }
+
+    ~List() {
+        for (int i = 0; i < numberOfElements; ++i)
+            Traits::destroy(alloc, arr + i);
+        if (arr != nullptr)
+            Traits::deallocate(alloc, arr, arraySize);
+    }
+
+    // Time complexity O(N) worst case. Make room for capacity elements without reallocations
+    void reserve(int capacity) {
+        if (capacity > arraySize)
+            reallocate(capacity);
+    }
 
-            delete [] arr;
-            arraySize *= 2;
-            arr = tempArr;
+    /*
+     * Time complexity O(N) worst case, O(1) amortized
+     * Construct the new element right in the array from args.
+     * On reallocation the elements are moved, not copied.
+     */
+    template <typename... Args>
+    T& emplace(Args&&... args) {
+        if (numberOfElements == arraySize) {
+            T item(std::forward<Args>(args)...); // args may refer to an element of the List
+            reallocate(arraySize == 0 ? 1 : arraySize * 2);
+            Traits::construct(alloc, arr + numberOfElements, std::move(item));
+        } else {
+            Traits::construct(alloc, arr + numberOfElements, std::forward<Args>(args)...);
         }
+        return arr[numberOfElements++];
+    }
 
-        arr[numberOfElements] = item;
-        numberOfElements++;
+    // Time complexity O(N) worst case, O(1) amortized
+    void push(T item) {
+        emplace(std::move(item));
     }
 
     // Time complexity O(1) worst case
@@ -50,7 +397,7 @@ public:
         if (0 < index && index >= numberOfElements) {
             cout << "There are no elements with index = " << index << " in the array." << endl;
             cout << "Returning the first element." << endl;
-            return arr[0];
+            return numberOfElements == 0 ? T() : arr[0];
         }
         return arr[index];
     }
@@ -76,86 +423,339 @@ public:
     virtual T greatest() = 0; // return the greatest element
     virtual T get(int i) = 0; // return the i-th least element
     virtual int indexOf(T item) = 0; // return the index of an element (in a sorted sequence)
+    virtual int lowerBound(const T& item) = 0; // return the index of the first element which is not less than item
+    virtual int upperBound(const T& item) = 0; // return the index of the first element which is greater than item
     virtual void remove(int i) = 0; // remove i-th least element from the Sorted List
     virtual List<T> searchRange(T from, T to) = 0; // find all items between from and to
     virtual int size() = 0; // return the size of the Sorted List
     virtual bool isEmpty() = 0; // return whether the Sorted List is empty
 };
 
+/*
+ * Lazy view of the elements between two positions of a Sorted List.
+ *
+ * Unlike searchRange, it does not copy the elements into a new List:
+ * iterators of the view point right into the storage of the Sorted List
+ * and yield the elements by const reference. Each implementation of
+ * SortedList provides its own iterator type and a range(from, to) method.
+ *
+ * The view is valid until the Sorted List is modified.
+ */
+template <typename Iterator>
+class SortedRange {
+private:
+    Iterator first;
+    Iterator last;
+public:
+    SortedRange(Iterator first, Iterator last) : first(first), last(last) {}
+
+    Iterator begin() const {
+        return first;
+    }
+
+    Iterator end() const {
+        return last;
+    }
+
+    bool isEmpty() const {
+        return first == last;
+    }
+};
+
+/*
+ * Sort the array [first, last) using all the cores.
+ *
+ * Time complexity: O(N log N / P + N log P) worst case
+ * P - number of threads.
+ *
+ * The array is split into P chunks which are sorted in parallel,
+ * then neighbouring chunks are merged in parallel, doubling the chunk size
+ * every round. Small arrays are sorted in the current thread, since starting
+ * the threads costs more than sorting them.
+ */
+template <typename T>
+void parallelSort(T* first, T* last) {
+    const long long minParallelSize = 1 << 16;
+    long long n = last - first;
+    long long threads = thread::hardware_concurrency();
+
+    if (n < minParallelSize || threads <= 1) {
+        sort(first, last);
+        return;
+    }
+    if (threads > n / minParallelSize)
+        threads = n / minParallelSize;
+
+    long long chunk = (n + threads - 1) / threads;
+    vector<thread> workers;
+    for (long long begin = 0; begin < n; begin += chunk)
+        workers.emplace_back([=] { sort(first + begin, first + min(n, begin + chunk)); });
+    for (thread& worker : workers)
+        worker.join();
+
+    for (; chunk < n; chunk *= 2) {
+        workers.clear();
+        for (long long begin = 0; begin + chunk < n; begin += 2 * chunk)
+            workers.emplace_back([=] { inplace_merge(first + begin, first + begin + chunk, first + min(n, begin + 2 * chunk)); });
+        for (thread& worker : workers)
+            worker.join();
+    }
+}
+
+/*
+ * Range count kernels for numeric keys.
+ *
+ * countInRange returns the number of keys with lo <= key <= hi.
+ *
+ * A plain loop with if (lo <= key && key <= hi) mispredicts a branch on every
+ * boundary of the range. The kernels compare several keys with one instruction
+ * (2 with SSE2, 4 with AVX2, 8 with AVX-512) and turn the result into a bit mask,
+ * so there are no data-dependent branches and the scan is bound by memory bandwidth.
+ * The best kernel for the CPU is chosen once, at the first call.
+ *
+ * Time complexity: O(N / W) worst case, W - number of keys compared at once.
+ */
+typedef int (*CountInRangeKernel)(const double* keys, int n, double lo, double hi);
+
+int countInRangeScalar(const double* keys, int n, double lo, double hi) {
+    int count = 0;
+    for (int id = 0; id < n; ++id)
+        count += (lo <= keys[id]) & (keys[id] <= hi);
+    return count;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// No popcnt here: SSE2 CPUs may not have it, and a 2-bit mask is counted with a shift
+__attribute__((target("sse2")))
+int countInRangeSse2(const double* keys, int n, double lo, double hi) {
+    __m128d low = _mm_set1_pd(lo), high = _mm_set1_pd(hi);
+    int count = 0, id = 0;
+    for (; id + 2 <= n; id += 2) {
+        __m128d key = _mm_loadu_pd(keys + id);
+        int mask = _mm_movemask_pd(_mm_and_pd(_mm_cmpge_pd(key, low), _mm_cmple_pd(key, high)));
+        count += (mask & 1) + (mask >> 1);
+    }
+    return count + countInRangeScalar(keys + id, n - id, lo, hi);
+}
+
+__attribute__((target("avx2,popcnt")))
+int countInRangeAvx2(const double* keys, int n, double lo, double hi) {
+    __m256d low = _mm256_set1_pd(lo), high = _mm256_set1_pd(hi);
+    int count = 0, id = 0;
+    for (; id + 8 <= n; id += 8) {
+        __m256d first = _mm256_loadu_pd(keys + id);
+        __m256d second = _mm256_loadu_pd(keys + id + 4);
+        __m256d firstInside = _mm256_and_pd(_mm256_cmp_pd(first, low, _CMP_GE_OQ), _mm256_cmp_pd(first, high, _CMP_LE_OQ));
+        __m256d secondInside = _mm256_and_pd(_mm256_cmp_pd(second, low, _CMP_GE_OQ), _mm256_cmp_pd(second, high, _CMP_LE_OQ));
+        count += __builtin_popcount(_mm256_movemask_pd(firstInside) | (_mm256_movemask_pd(secondInside) << 4));
+    }
+    return count + countInRangeScalar(keys + id, n - id, lo, hi);
+}
+
+__attribute__((target("avx512f,popcnt")))
+int countInRangeAvx512(const double* keys, int n, double lo, double hi) {
+    __m512d low = _mm512_set1_pd(lo), high = _mm512_set1_pd(hi);
+    int count = 0, id = 0;
+    for (; id + 8 <= n; id += 8) {
+        __m512d key = _mm512_loadu_pd(keys + id);
+        __mmask8 inside = _mm512_cmp_pd_mask(key, low, _CMP_GE_OQ) & _mm512_cmp_pd_mask(key, high, _CMP_LE_OQ);
+        count += __builtin_popcount(inside);
+    }
+    return count + countInRangeScalar(keys + id, n - id, lo, hi);
+}
+#endif
+
+CountInRangeKernel selectCountInRangeKernel() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    // the AVX kernels count the mask bits with the popcnt instruction
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("popcnt"))
+        return countInRangeAvx512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+        return countInRangeAvx2;
+    if (__builtin_cpu_supports("sse2"))
+        return countInRangeSse2;
+#endif
+    return countInRangeScalar;
+}
+
+int countInRange(const double* keys, int n, double lo, double hi) {
+    static const CountInRangeKernel kernel = selectCountInRangeKernel();
+    return kernel(keys, n, lo, hi);
+}
+
+/*
+ * Number of the first keys of a sorted window which go before the lower (upper) bound of item.
+ * ArraySortedList finishes binary search with it, when the window is small enough.
+ * For doubles it is the range count kernel above, so the last (hard to predict)
+ * steps of binary search are replaced with a few vector comparisons.
+ */
 template <typename T>
+int countBefore(const T* keys, int n, const T& item, bool upper) {
+    int count = 0;
+    for (int id = 0; id < n; ++id)
+        count += upper ? !(item < keys[id]) : keys[id] < item;
+    return count;
+}
+
+inline int countBefore(const double* keys, int n, const double& item, bool upper) {
+    if (upper)
+        return countInRange(keys, n, -HUGE_VAL, item);
+    return n - countInRange(keys, n, item, HUGE_VAL);
+}
+
+template <typename T, typename Alloc = allocator<T>>
 class ArraySortedList : SortedList <T> {
 private:
+    typedef allocator_traits<Alloc> Traits;
+
+    Alloc alloc; // gives raw memory, the elements are constructed only when added
     T* array; // dynamic array, where we will store our data
     int arraySize; // size of the array
     int numberOfElements; // actual number of elements in the array
+
+    // Binary search stops at a window of this size and counts the rest with countBefore
+    static const int linearSearchWindow = is_same<T, double>::value ? 32 : 0;
+
+    /*
+     * Time complexity: O(N) worst case
+     * Move the elements into raw storage of the new size.
+     * Slots after the elements stay not constructed.
+     */
+    void reallocate(int newSize) {
+        T* tempArr = Traits::allocate(alloc, newSize);
+
+        for (int id = 0; id < numberOfElements; ++id) {
+            Traits::construct(alloc, tempArr + id, std::move(array[id]));
+            Traits::destroy(alloc, array + id);
+        }
+
+        if (array != nullptr)
+            Traits::deallocate(alloc, array, arraySize);
+        arraySize = newSize;
+        array = tempArr;
+    }
 public:
     // Constructor
-    ArraySortedList() {
-        array = new T[1];
-        arraySize = 1;
+    explicit ArraySortedList(const Alloc& alloc = Alloc()) : alloc(alloc) {
+        array = nullptr;
+        arraySize = 0;
         numberOfElements = 0;
     }
 
+    ~ArraySortedList() {
+        for (int id = 0; id < numberOfElements; ++id)
+            Traits::destroy(alloc, array + id);
+        if (array != nullptr)
+            Traits::deallocate(alloc, array, arraySize);
+    }
+
+    ArraySortedList(const ArraySortedList&) = delete;
+    ArraySortedList& operator=(const ArraySortedList&) = delete;
+
+    /*
+     * Time complexity: O(N) worst case
+     * Make room for capacity elements, so next adds do not reallocate.
+     */
+    void reserve(int capacity) {
+        if (capacity > arraySize)
+            reallocate(capacity);
+    }
+
+    /*
+     * Constructor from an unsorted batch [first, last), see addAll.
+     */
+    template <typename Iterator>
+    ArraySortedList(Iterator first, Iterator last, const Alloc& alloc = Alloc()) : ArraySortedList(alloc) {
+        addAll(first, last);
+    }
+
+    /*
+     * Time complexity: O(M log M / P + N + M) worst case
+     * N - actual number of elements in the array.
+     * M - number of elements in the batch.
+     * P - number of threads.
+     *
+     * Adding the elements one by one takes O(N) shifts per element, i.e. O((N + M) * M).
+     * Instead:
+     *   (1) copy the batch and sort it (in parallel for big batches)
+     *   (2) make sure the array can store N + M elements (double strategy)
+     *   (3) merge the array and the batch from the end: the greatest of the two
+     *       tails goes to the last free slot. Every element is moved once, so it is linear.
+     */
+    template <typename Iterator>
+    void addAll(Iterator first, Iterator last) {
+        vector<T> batch(first, last);
+        parallelSort(batch.data(), batch.data() + batch.size());
+
+        int batchSize = (int) batch.size();
+        if (numberOfElements + batchSize > arraySize) {
+            int newSize = arraySize == 0 ? 1 : arraySize;
+            while (newSize < numberOfElements + batchSize)
+                newSize *= 2;
+            reallocate(newSize);
+        }
+
+        // Slots after numberOfElements are not constructed yet
+        int arrayId = numberOfElements - 1;
+        int batchId = batchSize - 1;
+        for (int id = numberOfElements + batchSize - 1; batchId >= 0; --id) {
+            T& source = arrayId >= 0 && batch[batchId] < array[arrayId] ? array[arrayId--] : batch[batchId--];
+            if (id >= numberOfElements)
+                Traits::construct(alloc, array + id, std::move(source));
+            else
+                array[id] = std::move(source);
+        }
+        numberOfElements += batchSize;
+    }
+
     /*
-    * Time complexity: O(N * K) worst case
+    * Time complexity: O(N + log N * K) worst case
     * N - actual number of elements in the array.
     * K - number of iterations for comparing the objects
     *
     * 1) If we won't resize the array:
-    *   We will go through all the elements until we find an element larger than the item,
-    *   then we swap elements from the end, till found this element. All in all, it takes linear
-    *   time.
-    *   Also, if we have type T = string, every comparison will take K iterations in the worst case,
-    *   where K is the length of the strings: O(2K) = O(K).
-    *   In the worst case, if we will compare all strings, i.e.
-    *   go in the loop till the end, time complexity will be O(N * K)
+    *   We find the position of the item with binary search (see lowerBound), it takes
+    *   O(log N * K) for strings of length K. Then we move the elements after the position
+    *   one slot to the right, starting from the end. It takes linear time.
+    *   Elements are moved, not copied, so for T = string only pointers are moved.
     *
-    *   Explanation: Assume we have all string with the same length K. Thus, to compare the
-    *   whole string we need to compare each char, which will take K iterations.
-    *   (abcd v abce : a = a, b = b, c = c, but d < e => abcd < abce)
-    *
-    * 2) If we wll resize the array:
-    *   (1) create new array B with doubled size of A
-    *   (2) store elements of A in B
-    *   (3) delete A
-    *   (4) reassign array B into A
-    *   It will take linear time.
+    * 2) If we will resize the array:
+    *   (1) allocate raw storage B with doubled size of A
+    *   (2) move elements of A into B
+    *   (3) free A
+    *   It will take linear time, but amortized O(1) per add.
     *   After that do the steps of 1) (linear time)
     *   So, the time complexity is O(N + N) = O(N) worst case
+    *
+    * Item is taken by value: pass an rvalue (or use emplace) and it is never copied.
     */
     void add(T item) override {
         // Resize part
-        if (numberOfElements == arraySize) {
-            T* tempArr = new T[arraySize * 2];
-
-            for (int id = 0; id < arraySize; ++id)
-                tempArr[id] = array[id];
-
-            delete [] array;
-            arraySize *= 2;
-            array = tempArr;
-        }
+        if (numberOfElements == arraySize)
+            reallocate(arraySize == 0 ? 1 : arraySize * 2);
 
         // Add part
-        if (numberOfElements == 0) {
-            array[numberOfElements] = item;
+        int position = lowerBound(item);
+        if (position == numberOfElements) {
+            Traits::construct(alloc, array + numberOfElements, std::move(item));
         } else {
-            bool added = false;
-            for (int id = 0; id < numberOfElements; ++id) {
-                if (item <= array[id]) {
-                    added = true;
-                    for (int p_id = numberOfElements; p_id > id; --p_id)
-                        swap(array[p_id - 1], array[p_id]);
-                    array[id] = item;
-                    break;
-                }
-            }
-            if (!added)
-                array[numberOfElements] = item;
+            Traits::construct(alloc, array + numberOfElements, std::move(array[numberOfElements - 1]));
+            for (int id = numberOfElements - 1; id > position; --id)
+                array[id] = std::move(array[id - 1]);
+            array[position] = std::move(item);
         }
         numberOfElements++;
     }
 
+    /*
+     * Construct the item from args and add it, see add.
+     */
+    template <typename... Args>
+    void emplace(Args&&... args) {
+        add(T(std::forward<Args>(args)...));
+    }
+
     /*
      * Time complexity: O(1) worst case
      * Since we have a Sorted List, the minimum element is
@@ -164,7 +764,7 @@ public:
     T least() override {
         if (numberOfElements == 0) {
             cout << "There are no elements in the array." << endl;
-            return array[numberOfElements];
+            return T();
         } else
             return array[0];
     }
@@ -177,7 +777,7 @@ public:
     T greatest() override {
         if (numberOfElements == 0) {
             cout << "There are no elements in the array." << endl;
-            return array[numberOfElements];
+            return T();
         } else
             return array[numberOfElements - 1];
     }
@@ -187,41 +787,64 @@ public:
      * Since we know the id of the element and accessing the array takes constant time.
      */
     T get(int i) override {
-        if (i < 0 || i > numberOfElements) {
+        if (i <= 0 || i > numberOfElements) {
             cout << "There are no " << i << "th element in the array." << endl;
             cout << "Returning the least element." << endl;
-            return array[0];
+            return least();
         }
         return array[i - 1];
     }
 
     /*
-     * Time complexity: O(N * K) worst case
+     * Time complexity: O(log N * K) worst case
      * N - actual number of elements in the array.
      * K - number of iterations for comparing the objects.
      *
-     * In the worst case, if item will be equal to the maximum element or it does not exist
-     * we will go through all the elements of the array, which will take linear time O(N).
-     *
-     *
-     * Also, if we have type T = string, every comparison will take K iterations in the worst case,
-     * where K is the length of the strings O(K).
-     *
-     * Explanation: Assume we have all string with the same length K. Thus, to compare the
-     * whole string we need to compare each char, which will take K iterations.
-     * ("abcd" v "abce" : a = a, b = b, c = c, but d < e => abcd < abce)
+     * Binary search: the array is sorted, so all elements before the answer are
+     * less than item and all elements after it are not. Each iteration halves
+     * the segment [left, right), so we do log N comparisons.
+     * For doubles the last window of linearSearchWindow elements is counted with vector comparisons.
      */
-    int indexOf(T item) override {
-        int index = -1;
+    int lowerBound(const T& item) override {
+        int left = 0, right = numberOfElements;
+        while (right - left > linearSearchWindow) {
+            int middle = (left + right) / 2;
+            if (array[middle] < item)
+                left = middle + 1;
+            else
+                right = middle;
+        }
+        return left + countBefore(array + left, right - left, item, false);
+    }
 
-        for (int id = 0; id < numberOfElements; ++id) {
-            if (array[id] == item) {
-                index = id;
-                break;
-            }
+    /*
+     * Time complexity: O(log N * K) worst case
+     * Same binary search as lowerBound, but skips the elements equal to item.
+     */
+    int upperBound(const T& item) override {
+        int left = 0, right = numberOfElements;
+        while (right - left > linearSearchWindow) {
+            int middle = (left + right) / 2;
+            if (item < array[middle])
+                right = middle;
+            else
+                left = middle + 1;
         }
+        return left + countBefore(array + left, right - left, item, true);
+    }
+
+    /*
+     * Time complexity: O(log N * K) worst case
+     * N - actual number of elements in the array.
+     * K - number of iterations for comparing the objects.
+     *
+     * The first occurrence of item is the lower bound of it,
+     * if the element there is not equal to item, there is no such element.
+     */
+    int indexOf(T item) override {
+        int index = lowerBound(item);
 
-        if (index == -1) {
+        if (index == numberOfElements || !(array[index] == item)) {
             cout << item << " is not in the ArraySortedList." << endl;
             cout << "Returning id of the least element." << endl;
             return 0;
@@ -234,8 +857,8 @@ public:
      * N - actual number of elements in the array.
      *
      * In the worst case we need to remove first element of the array.
-     * Due this reason, we need to swap all elements till the end.
-     * Swap method takes constant time. Thus, it will take linear time.
+     * Due this reason, we need to move all elements till the end one slot to the left.
+     * Moving takes constant time (for T = string only the pointers are moved). Thus, it will take linear time.
      */
     void remove(int i) override {
         if (i <= 0 || i > numberOfElements) {
@@ -244,42 +867,44 @@ public:
         }
 
         for (int id = i - 1; id < numberOfElements - 1; ++id)
-            swap(array[id], array[id + 1]);
+            array[id] = std::move(array[id + 1]);
 
+        Traits::destroy(alloc, array + numberOfElements - 1);
         numberOfElements--;
     }
 
     /*
-     * Time complexity: O(N * K) worst case
+     * Time complexity: O(log N * K + M) worst case
      * N - actual number of elements in the array.
      * K - number of iterations for comparing the objects.
+     * M - number of found elements.
      *
-     * In all cases we go throw all elements of array.
-     * In the worst case, we should add into the List all the elements
-     * of array, i.e. execute push() method N times. Worst case of push
-     * is O(N) (double strategy), but array won't double every added element, due
-     * to that amortized cost of push is O(1). So, the time complexity of the
-     * searchRange method is linear.
-     *
-     * Also, if we have type T = string, every comparison will take K iterations in the worst case,
-     * where K is the length of the strings: O(2K) = O(K).
-     *
-     * Explanation: Assume we have all string with the same length K. Thus, to compare the
-     * whole string we need to compare each char, which will take K iterations.
-     * (abcd v abce : a = a, b = b, c = c, but d < e => abcd < abce)
+     * Elements between from and to are exactly the elements with indices
+     * [lowerBound(from), upperBound(to)), both bounds take O(log N * K).
+     * Then we push M elements into the List, amortized cost of push is O(1).
      */
     List<T> searchRange(T from, T to) override {
         List<T> lst;
 
-        for (int id = 0; id < numberOfElements; ++id) {
-            if (from <= array[id] && array[id] <= to) {
-                lst.push(array[id]);
-            }
-        }
+        int last = upperBound(to);
+        for (int id = lowerBound(from); id < last; ++id)
+            lst.push(array[id]);
 
         return lst;
     }
 
+    /*
+     * Time complexity: O(log N * K) worst case
+     * Same bounds as in searchRange, but nothing is copied:
+     * the view is just a pair of pointers into the array.
+     */
+    SortedRange<const T*> range(T from, T to) {
+        const T* first = array + lowerBound(from);
+        if (to < from)
+            return SortedRange<const T*>(first, first);
+        return SortedRange<const T*>(first, array + upperBound(to));
+    }
+
     /*
      * Time complexity: O(1) worst case
      * Just return value of variable. Constant time.
@@ -297,7 +922,2194 @@ public:
     }
 };
 
-int main() {
+/*
+ * Array Sorted List with a compile-time inline capacity.
+ *
+ * Most of the lists are tiny, but ArraySortedList starts with a heap block of one
+ * element and doubles it. SmallSortedList keeps up to N elements in a buffer inside
+ * the object, so a list of at most N elements never touches the heap. When the
+ * (N + 1)th element comes, the elements are moved to a heap array of size 2N,
+ * which grows with the double strategy from then on.
+ *
+ * While the elements are inline, the position of an item is found with countBefore:
+ * it compares the item with all N elements without branches (or with vector
+ * comparisons for doubles), which for small N is faster than mispredicted binary search.
+ */
+template <typename T, int N>
+class SmallSortedList : SortedList <T> {
+private:
+    typedef allocator<T> Alloc;
+    typedef allocator_traits<Alloc> Traits;
+
+    static_assert(N > 0, "inline capacity must be positive");
+
+    Alloc alloc;
+    alignas(T) unsigned char buffer[N * sizeof(T)]; // inline raw storage for the first N elements
+    T* array; // buffer or the heap array
+    int arraySize; // size of the array
+    int numberOfElements; // actual number of elements in the array
+
+    bool isInline() const {
+        return array == reinterpret_cast<const T*>(buffer);
+    }
+
+    /*
+     * Time complexity: O(N) worst case
+     * Move the elements into a heap array of the new size, the inline buffer is never freed.
+     */
+    void reallocate(int newSize) {
+        T* tempArr = Traits::allocate(alloc, newSize);
+
+        for (int id = 0; id < numberOfElements; ++id) {
+            Traits::construct(alloc, tempArr + id, std::move(array[id]));
+            Traits::destroy(alloc, array + id);
+        }
+
+        if (!isInline())
+            Traits::deallocate(alloc, array, arraySize);
+        arraySize = newSize;
+        array = tempArr;
+    }
+
+    /*
+     * Time complexity: O(log N * K) worst case
+     * Binary search on the heap array, the inline one is counted at once.
+     */
+    int bound(const T& item, bool upper) {
+        int left = 0, right = numberOfElements;
+        if (!isInline()) {
+            while (right - left > N) {
+                int middle = (left + right) / 2;
+                if (upper ? !(item < array[middle]) : array[middle] < item)
+                    left = middle + 1;
+                else
+                    right = middle;
+            }
+        }
+        return left + countBefore(array + left, right - left, item, upper);
+    }
+public:
+    // Constructor
+    SmallSortedList() {
+        array = reinterpret_cast<T*>(buffer);
+        arraySize = N;
+        numberOfElements = 0;
+    }
+
+    ~SmallSortedList() {
+        for (int id = 0; id < numberOfElements; ++id)
+            Traits::destroy(alloc, array + id);
+        if (!isInline())
+            Traits::deallocate(alloc, array, arraySize);
+    }
+
+    SmallSortedList(const SmallSortedList&) = delete;
+    SmallSortedList& operator=(const SmallSortedList&) = delete;
+
+    /*
+     * Time complexity: O(N) worst case
+     * Make room for capacity elements, so next adds do not reallocate.
+     */
+    void reserve(int capacity) {
+        if (capacity > arraySize)
+            reallocate(capacity);
+    }
+
+    /*
+     * Time complexity: O(N + log N * K) worst case, O(N) without heap allocation for N <= inline capacity
+     * Same as ArraySortedList::add: find the position and move the tail one slot to the right.
+     * The first spill moves the elements from the buffer to the heap.
+     */
+    void add(T item) override {
+        if (numberOfElements == arraySize)
+            reallocate(arraySize * 2);
+
+        int position = lowerBound(item);
+        if (position == numberOfElements) {
+            Traits::construct(alloc, array + numberOfElements, std::move(item));
+        } else {
+            Traits::construct(alloc, array + numberOfElements, std::move(array[numberOfElements - 1]));
+            for (int id = numberOfElements - 1; id > position; --id)
+                array[id] = std::move(array[id - 1]);
+            array[position] = std::move(item);
+        }
+        numberOfElements++;
+    }
+
+    /*
+     * Construct the item from args and add it, see add.
+     */
+    template <typename... Args>
+    void emplace(Args&&... args) {
+        add(T(std::forward<Args>(args)...));
+    }
+
+    /*
+     * Time complexity: O(1) worst case
+     */
+    T least() override {
+        if (numberOfElements == 0) {
+            cout << "There are no elements in the array." << endl;
+            return T();
+        } else
+            return array[0];
+    }
+
+    /*
+     * Time complexity: O(1) worst case
+     */
+    T greatest() override {
+        if (numberOfElements == 0) {
+            cout << "There are no elements in the array." << endl;
+            return T();
+        } else
+            return array[numberOfElements - 1];
+    }
+
+    /*
+     * Time complexity: O(1) worst case
+     */
+    T get(int i) override {
+        if (i <= 0 || i > numberOfElements) {
+            cout << "There are no " << i << "th element in the array." << endl;
+            cout << "Returning the least element." << endl;
+            return least();
+        }
+        return array[i - 1];
+    }
+
+    /*
+     * Time complexity: O(N * K) inline, O(log N * K) on the heap
+     */
+    int lowerBound(const T& item) override {
+        return bound(item, false);
+    }
+
+    /*
+     * Time complexity: O(N * K) inline, O(log N * K) on the heap
+     */
+    int upperBound(const T& item) override {
+        return bound(item, true);
+    }
+
+    /*
+     * Time complexity: O(log N * K) worst case, see lowerBound.
+     */
+    int indexOf(T item) override {
+        int index = lowerBound(item);
+
+        if (index == numberOfElements || !(array[index] == item)) {
+            cout << item << " is not in the SmallSortedList." << endl;
+            cout << "Returning id of the least element." << endl;
+            return 0;
+        }
+        return index;
+    }
+
+    /*
+     * Time complexity: O(N) worst case
+     * Move the tail one slot to the left. The list does not move back into the buffer.
+     */
+    void remove(int i) override {
+        if (i <= 0 || i > numberOfElements) {
+            cout << "There are no " << i << "th element in the array." << endl;
+            return;
+        }
+
+        for (int id = i - 1; id < numberOfElements - 1; ++id)
+            array[id] = std::move(array[id + 1]);
+
+        Traits::destroy(alloc, array + numberOfElements - 1);
+        numberOfElements--;
+    }
+
+    /*
+     * Time complexity: O(log N * K + M) worst case
+     * M - number of found elements.
+     */
+    List<T> searchRange(T from, T to) override {
+        List<T> lst;
+
+        int last = upperBound(to);
+        for (int id = lowerBound(from); id < last; ++id)
+            lst.push(array[id]);
+
+        return lst;
+    }
+
+    /*
+     * Time complexity: O(log N * K) worst case
+     * Pointers into the buffer (or the heap array), valid until the next add or remove.
+     */
+    SortedRange<const T*> range(T from, T to) {
+        const T* first = array + lowerBound(from);
+        if (to < from)
+            return SortedRange<const T*>(first, first);
+        return SortedRange<const T*>(first, array + upperBound(to));
+    }
+
+    /*
+     * Time complexity: O(1) worst case
+     */
+    int size() override {
+        return numberOfElements;
+    }
+
+    /*
+     * Time complexity: O(1) worst case
+     */
+    bool isEmpty() override {
+        return numberOfElements == 0;
+    }
+};
+
+/*
+ * Sorted List on top of a Packed Memory Array (PMA).
+ *
+ * All elements are stored in one sequential array, but the array intentionally
+ * has gaps. The array is split into segments of segmentSize slots, elements of
+ * each segment are packed to the left of it, so the gaps are at the segment ends.
+ *
+ * Segments are the leaves of an implicit binary tree: a window of level L is a
+ * group of 2^L neighbouring segments. Every level has its own density thresholds,
+ * the higher the level, the tighter the thresholds. When a segment overflows
+ * (or becomes too sparse), we find the smallest window around it whose density is
+ * within the thresholds and spread its elements evenly. If even the whole array
+ * is out of the thresholds, we double (halve) the capacity.
+ *
+ * Number of elements of each segment is kept in a Fenwick tree, so we can find
+ * the i-th element without scanning the segments.
+ */
+template <typename T>
+class PackedSortedList : SortedList <T> {
+private:
+    T* array; // sequential storage with gaps
+    int* segmentCount; // actual number of elements in each segment
+    int* fenwick; // Fenwick tree over segmentCount (1-indexed)
+    int segmentSize; // number of slots in a segment
+    int numberOfSegments; // number of segments, always a power of two
+    int height; // height of the implicit tree of windows, log2(numberOfSegments)
+    int numberOfElements; // actual number of elements in the array
+    vector<T> buffer; // temporary storage for the elements of the window being redistributed
+
+    static const int minCapacity = 8;
+
+    /*
+     * Upper density threshold of a window of the given level.
+     * 1.0 for a single segment, 0.75 for the whole array.
+     */
+    double upperDensity(int level) {
+        if (height == 0)
+            return 1.0;
+        return 1.0 - 0.25 * level / height;
+    }
+
+    /*
+     * Lower density threshold of a window of the given level.
+     * 0.125 for a single segment, 0.25 for the whole array.
+     */
+    double lowerDensity(int level) {
+        if (height == 0)
+            return 0.0;
+        return 0.125 + 0.125 * level / height;
+    }
+
+    // Time complexity: O(log N) worst case
+    void fenwickAdd(int segment, int delta) {
+        for (int id = segment + 1; id <= numberOfSegments; id += id & -id)
+            fenwick[id] += delta;
+    }
+
+    // Time complexity: O(log N) worst case. Number of elements in the segments [0, segment)
+    int fenwickPrefix(int segment) {
+        int sum = 0;
+        for (int id = segment; id > 0; id -= id & -id)
+            sum += fenwick[id];
+        return sum;
+    }
+
+    // Time complexity: O(log N) worst case. Segment which contains the i-th least element
+    int fenwickFind(int i) {
+        int segment = 0;
+        for (int step = numberOfSegments; step > 0; step >>= 1) {
+            if (segment + step <= numberOfSegments && fenwick[segment + step] < i) {
+                segment += step;
+                i -= fenwick[segment];
+            }
+        }
+        return segment;
+    }
+
+    // Time complexity: O(N / log N) worst case
+    void fenwickBuild() {
+        for (int id = 1; id <= numberOfSegments; ++id)
+            fenwick[id] = segmentCount[id - 1];
+        for (int id = 1; id <= numberOfSegments; ++id) {
+            int parent = id + (id & -id);
+            if (parent <= numberOfSegments)
+                fenwick[parent] += fenwick[id];
+        }
+    }
+
+    /*
+     * Allocate empty storage for the given capacity.
+     * Segment size is the power of two which is close to log2(capacity),
+     * so a segment is shifted in O(log N).
+     */
+    void allocate(int capacity) {
+        int logCapacity = 0;
+        while ((1 << logCapacity) < capacity)
+            logCapacity++;
+
+        segmentSize = minCapacity;
+        while (segmentSize < logCapacity)
+            segmentSize *= 2;
+
+        numberOfSegments = capacity / segmentSize;
+        height = 0;
+        while ((1 << height) < numberOfSegments)
+            height++;
+
+        array = new T[capacity];
+        segmentCount = new int[numberOfSegments]();
+        fenwick = new int[numberOfSegments + 1]();
+    }
+
+    /*
+     * Time complexity: O(W) worst case, W - number of slots in the window.
+     * Move all elements of the window into the buffer.
+     */
+    void gather(int firstSegment, int segments) {
+        buffer.clear();
+        for (int s = firstSegment; s < firstSegment + segments; ++s)
+            for (int id = 0; id < segmentCount[s]; ++id)
+                buffer.push_back(std::move(array[s * segmentSize + id]));
+    }
+
+    /*
+     * Time complexity: O(W) worst case, W - number of slots in the window.
+     * Spread the elements of the buffer evenly among the segments of the window.
+     * Fenwick tree has to be updated by the caller.
+     */
+    void spread(int firstSegment, int segments) {
+        int total = (int) buffer.size();
+        int base = total / segments;
+        int extra = total % segments;
+
+        int taken = 0;
+        for (int s = firstSegment; s < firstSegment + segments; ++s) {
+            int count = base + (s - firstSegment < extra ? 1 : 0);
+            for (int id = 0; id < count; ++id)
+                array[s * segmentSize + id] = std::move(buffer[taken++]);
+            segmentCount[s] = count;
+        }
+    }
+
+    /*
+     * Time complexity: O(W + log N) worst case, W - number of slots in the window.
+     *
+     * Spread the buffer over the window and update the Fenwick tree inside it only.
+     * The window is aligned ([firstSegment, firstSegment + segments), segments is
+     * a power of two), so the nodes firstSegment + 1 .. firstSegment + segments - 1
+     * cover parts of the window and are built again from the new counts, while
+     * node firstSegment + segments and its ancestors cover the whole window and
+     * only get the change of its total.
+     */
+    void redistribute(int firstSegment, int segments) {
+        int oldTotal = 0;
+        for (int s = firstSegment; s < firstSegment + segments; ++s)
+            oldTotal += segmentCount[s];
+
+        spread(firstSegment, segments);
+
+        int last = firstSegment + segments; // Fenwick node of the whole window
+        for (int id = firstSegment + 1; id < last; ++id)
+            fenwick[id] = segmentCount[id - 1];
+        for (int id = firstSegment + 1; id < last; ++id) {
+            int parent = id + (id & -id);
+            if (parent < last)
+                fenwick[parent] += fenwick[id];
+        }
+        fenwickAdd(last - 1, (int) buffer.size() - oldTotal);
+    }
+
+    /*
+     * Time complexity: O(N) worst case
+     * Move all elements (they are already in the buffer) into the array of the new capacity.
+     */
+    void rebuild(int capacity) {
+        delete [] array;
+        delete [] segmentCount;
+        delete [] fenwick;
+
+        allocate(capacity);
+        spread(0, numberOfSegments);
+        fenwickBuild(); // new array, the whole tree is built in O(N / log N)
+    }
+
+    // Whether element goes before the lower (upper) bound of item
+    static bool before(const T& element, const T& item, bool upper) {
+        return upper ? !(item < element) : element < item;
+    }
+
+    /*
+     * Time complexity: O(log N * K) worst case
+     * K - number of iterations for comparing the objects.
+     *
+     * Binary search over the segments: find the first segment whose greatest element
+     * is not less than item (greater than item, if upper). The greatest element of
+     * segment s is array[s * segmentSize + segmentCount[s] - 1]. The thresholds keep the
+     * segments non-empty, except the tail of the array when there are fewer elements
+     * than segments; an empty segment is treated as greater than item, so the search
+     * never goes past it. If there is no such segment, return the first empty one
+     * (or the last one).
+     */
+    int findSegment(const T& item, bool upper = false) {
+        int left = 0, right = numberOfSegments - 1;
+        while (left < right) {
+            int middle = (left + right) / 2;
+            if (segmentCount[middle] != 0 && before(array[middle * segmentSize + segmentCount[middle] - 1], item, upper))
+                left = middle + 1;
+            else
+                right = middle;
+        }
+        return left;
+    }
+
+    /*
+     * Time complexity: O(log log N * K) worst case
+     * Position of the first element of the segment which is not less than item
+     * (greater than item, if upper).
+     */
+    int findInSegment(int segment, const T& item, bool upper = false) {
+        int left = 0, right = segmentCount[segment];
+        while (left < right) {
+            int middle = (left + right) / 2;
+            if (before(array[segment * segmentSize + middle], item, upper))
+                left = middle + 1;
+            else
+                right = middle;
+        }
+        return left;
+    }
+
+public:
+    /*
+     * Forward iterator over the array which skips the gaps.
+     * Always points to an element or to the end (segment == numberOfSegments).
+     */
+    class Cursor {
+    private:
+        const PackedSortedList* list;
+        int segment;
+        int position;
+
+        void skipGaps() {
+            while (segment < list->numberOfSegments && position >= list->segmentCount[segment]) {
+                segment++;
+                position = 0;
+            }
+        }
+    public:
+        Cursor(const PackedSortedList* list, int segment, int position) : list(list), segment(segment), position(position) {
+            skipGaps();
+        }
+
+        const T& operator*() const {
+            return list->array[segment * list->segmentSize + position];
+        }
+
+        const T* operator->() const {
+            return &**this;
+        }
+
+        Cursor& operator++() {
+            position++;
+            skipGaps();
+            return *this;
+        }
+
+        bool operator==(const Cursor& other) const {
+            return segment == other.segment && position == other.position;
+        }
+
+        bool operator!=(const Cursor& other) const {
+            return !(*this == other);
+        }
+    };
+
+    // Constructor
+    PackedSortedList() {
+        allocate(minCapacity);
+        numberOfElements = 0;
+    }
+
+    ~PackedSortedList() {
+        delete [] array;
+        delete [] segmentCount;
+        delete [] fenwick;
+    }
+
+    PackedSortedList(const PackedSortedList&) = delete;
+    PackedSortedList& operator=(const PackedSortedList&) = delete;
+
+    /*
+     * Time complexity: O(log^2 N) amortized moves of the elements
+     *
+     * 1) Find the segment and position in it using binary search: O(log N).
+     * 2) If the segment has a free slot, shift its tail to the right: O(log N).
+     * 3) Otherwise find the smallest window around the segment which is not too dense
+     *    and spread its elements evenly. A window of W slots is redistributed only
+     *    after Ω(W / log N) insertions into it, and a slot belongs to log N windows.
+     *    So, each insertion pays O(log^2 N) moves amortized.
+     * 4) If even the whole array is too dense, double the capacity: O(N),
+     *    but amortized O(1), as in the doubling strategy of ArraySortedList.
+     */
+    void add(T item) override {
+        int segment = findSegment(item);
+        int position = findInSegment(segment, item);
+
+        if (segmentCount[segment] < segmentSize) {
+            T* base = array + segment * segmentSize;
+            for (int id = segmentCount[segment]; id > position; --id)
+                base[id] = std::move(base[id - 1]);
+            base[position] = std::move(item);
+
+            segmentCount[segment]++;
+            fenwickAdd(segment, 1);
+            numberOfElements++;
+            return;
+        }
+
+        // The segment is full: look for the window which can accept one more element
+        for (int level = 1; level <= height; ++level) {
+            int segments = 1 << level;
+            int firstSegment = segment & ~(segments - 1);
+            int count = fenwickPrefix(firstSegment + segments) - fenwickPrefix(firstSegment);
+
+            if (count + 1 <= upperDensity(level) * segments * segmentSize) {
+                gather(firstSegment, segments);
+                buffer.insert(lower_bound(buffer.begin(), buffer.end(), item), std::move(item));
+                redistribute(firstSegment, segments);
+                numberOfElements++;
+                return;
+            }
+        }
+
+        // The whole array is too dense
+        gather(0, numberOfSegments);
+        buffer.insert(lower_bound(buffer.begin(), buffer.end(), item), std::move(item));
+        rebuild(numberOfSegments * segmentSize * 2);
+        numberOfElements++;
+    }
+
+    /*
+     * Time complexity: O(1) worst case
+     * The first segment is never empty, so the least element is the first slot of the array.
+     */
+    T least() override {
+        if (numberOfElements == 0) {
+            cout << "There are no elements in the array." << endl;
+            return array[0];
+        }
+        return array[0];
+    }
+
+    /*
+     * Time complexity: O(1) worst case
+     * The last segment is never empty (if there are at least numberOfSegments elements),
+     * otherwise, we take the last element with Fenwick tree.
+     */
+    T greatest() override {
+        if (numberOfElements == 0) {
+            cout << "There are no elements in the array." << endl;
+            return array[0];
+        }
+        int segment = numberOfSegments - 1;
+        if (segmentCount[segment] == 0)
+            segment = fenwickFind(numberOfElements);
+        return array[segment * segmentSize + segmentCount[segment] - 1];
+    }
+
+    /*
+     * Time complexity: O(log N) worst case
+     * Find the segment of the i-th element using Fenwick tree.
+     */
+    T get(int i) override {
+        if (i <= 0 || i > numberOfElements) {
+            cout << "There are no " << i << "th element in the array." << endl;
+            cout << "Returning the least element." << endl;
+            return array[0];
+        }
+        int segment = fenwickFind(i);
+        return array[segment * segmentSize + (i - 1 - fenwickPrefix(segment))];
+    }
+
+    /*
+     * Time complexity: O(log N * K) worst case
+     * K - number of iterations for comparing the objects.
+     *
+     * Binary search of the segment, then binary search inside the segment,
+     * then the number of elements before the segment from Fenwick tree.
+     */
+    int lowerBound(const T& item) override {
+        int segment = findSegment(item);
+        return fenwickPrefix(segment) + findInSegment(segment, item);
+    }
+
+    /*
+     * Time complexity: O(log N * K) worst case
+     * Same as lowerBound, but skips the elements equal to item.
+     */
+    int upperBound(const T& item) override {
+        int segment = findSegment(item, true);
+        return fenwickPrefix(segment) + findInSegment(segment, item, true);
+    }
+
+    /*
+     * Time complexity: O(log N * K) worst case
+     * Same searches as in lowerBound.
+     */
+    int indexOf(T item) override {
+        int segment = findSegment(item);
+        int position = findInSegment(segment, item);
+
+        if (position == segmentCount[segment] || !(array[segment * segmentSize + position] == item)) {
+            cout << item << " is not in the PackedSortedList." << endl;
+            cout << "Returning id of the least element." << endl;
+            return 0;
+        }
+        return fenwickPrefix(segment) + position;
+    }
+
+    /*
+     * Time complexity: O(log^2 N) amortized moves of the elements
+     * Shift the tail of the segment to the left: O(log N). If the segment becomes
+     * too sparse, redistribute the smallest window which is dense enough
+     * (amortized O(log^2 N)), or halve the capacity.
+     */
+    void remove(int i) override {
+        if (i <= 0 || i > numberOfElements) {
+            cout << "There are no " << i << "th element in the array." << endl;
+            return;
+        }
+
+        int segment = fenwickFind(i);
+        T* base = array + segment * segmentSize;
+        for (int id = i - 1 - fenwickPrefix(segment); id < segmentCount[segment] - 1; ++id)
+            base[id] = std::move(base[id + 1]);
+
+        segmentCount[segment]--;
+        fenwickAdd(segment, -1);
+        numberOfElements--;
+
+        if (height == 0 || segmentCount[segment] >= lowerDensity(0) * segmentSize)
+            return;
+
+        // The segment is too sparse: look for the window which is dense enough
+        for (int level = 1; level <= height; ++level) {
+            int segments = 1 << level;
+            int firstSegment = segment & ~(segments - 1);
+            int count = fenwickPrefix(firstSegment + segments) - fenwickPrefix(firstSegment);
+
+            if (count >= lowerDensity(level) * segments * segmentSize) {
+                gather(firstSegment, segments);
+                redistribute(firstSegment, segments);
+                return;
+            }
+        }
+
+        // The whole array is too sparse
+        gather(0, numberOfSegments);
+        rebuild(numberOfSegments * segmentSize / 2);
+    }
+
+    /*
+     * Time complexity: O(log N * K + M) worst case
+     * M - number of found elements (plus the gaps between them).
+     *
+     * Find the first element which is not less than from, then walk
+     * through the array skipping the gaps, until the element is greater than to.
+     */
+    List<T> searchRange(T from, T to) override {
+        List<T> lst;
+        if (numberOfElements == 0)
+            return lst;
+
+        int segment = findSegment(from);
+        int position = findInSegment(segment, from);
+        for (; segment < numberOfSegments; ++segment, position = 0) {
+            for (; position < segmentCount[segment]; ++position) {
+                T& current = array[segment * segmentSize + position];
+                if (to < current)
+                    return lst;
+                lst.push(current);
+            }
+        }
+
+        return lst;
+    }
+
+    /*
+     * Time complexity: O(log N * K) worst case
+     * Cursors to the lower bound of from and to the upper bound of to.
+     * Nothing is copied, the elements are read from the array while iterating.
+     */
+    SortedRange<Cursor> range(T from, T to) {
+        int firstSegment = findSegment(from);
+        Cursor first(this, firstSegment, findInSegment(firstSegment, from));
+        if (to < from)
+            return SortedRange<Cursor>(first, first);
+
+        int lastSegment = findSegment(to, true);
+        return SortedRange<Cursor>(first, Cursor(this, lastSegment, findInSegment(lastSegment, to, true)));
+    }
+
+    /*
+     * Time complexity: O(1) worst case
+     */
+    int size() override {
+        return numberOfElements;
+    }
+
+    /*
+     * Time complexity: O(1) worst case
+     */
+    bool isEmpty() override {
+        return numberOfElements == 0;
+    }
+};
+
+/*
+ * Sorted List on top of an order-statistic B+-tree.
+ *
+ * All elements are stored in the leaves, leaves are linked into a list,
+ * so we can walk through the elements in sorted order. Leaves hold a small
+ * sorted array which fits into one or two cache lines for small types.
+ *
+ * Every inner node stores for each child:
+ *  1) the number of elements in its subtree, so we can descend by rank;
+ *  2) a separator key, which is not greater than any element of the child and
+ *     not less than any element of the previous child, so we can descend by key.
+ *     Separators may become smaller than the actual minimum after removals,
+ *     it does not break this invariant.
+ */
+template <typename T>
+class BPlusTreeSortedList : SortedList <T> {
+private:
+    static const int leafCapacity = 128 / sizeof(T) < 8 ? 8 : 128 / sizeof(T);
+    static const int innerCapacity = 16;
+
+    struct Node {
+        bool isLeaf;
+        int size; // number of elements for a leaf, number of children for an inner node
+    };
+
+    struct Leaf : Node {
+        T keys[leafCapacity];
+        Leaf* prev;
+        Leaf* next;
+    };
+
+    struct Inner : Node {
+        Node* children[innerCapacity];
+        int counts[innerCapacity]; // number of elements in the subtree of each child
+        T keys[innerCapacity]; // keys[c] separates children c - 1 and c, keys[0] is not used
+    };
+
+    Node* root;
+    Leaf* first; // the leftmost leaf, stores the least element
+    Leaf* last; // the rightmost leaf, stores the greatest element
+    int numberOfElements;
+
+    Leaf* newLeaf() {
+        Leaf* leaf = new Leaf();
+        leaf->isLeaf = true;
+        leaf->size = 0;
+        leaf->prev = leaf->next = nullptr;
+        return leaf;
+    }
+
+    Inner* newInner() {
+        Inner* inner = new Inner();
+        inner->isLeaf = false;
+        inner->size = 0;
+        return inner;
+    }
+
+    void destroy(Node* node) {
+        if (!node->isLeaf) {
+            Inner* inner = (Inner*) node;
+            for (int c = 0; c < inner->size; ++c)
+                destroy(inner->children[c]);
+            delete inner;
+        } else {
+            delete (Leaf*) node;
+        }
+    }
+
+    // Time complexity: O(B) worst case, B - capacity of the node
+    int subtreeSize(Node* node) {
+        if (node->isLeaf)
+            return node->size;
+        Inner* inner = (Inner*) node;
+        int total = 0;
+        for (int c = 0; c < inner->size; ++c)
+            total += inner->counts[c];
+        return total;
+    }
+
+    // Whether element goes before the lower (upper) bound of item
+    static bool before(const T& element, const T& item, bool upper) {
+        return upper ? !(item < element) : element < item;
+    }
+
+    /*
+     * Time complexity: O(log B * K) worst case
+     * Position of the first key which is not less than item (greater than item, if upper)
+     */
+    int boundInLeaf(Leaf* leaf, const T& item, bool upper = false) {
+        int left = 0, right = leaf->size;
+        while (left < right) {
+            int middle = (left + right) / 2;
+            if (before(leaf->keys[middle], item, upper))
+                left = middle + 1;
+            else
+                right = middle;
+        }
+        return left;
+    }
+
+    /*
+     * Time complexity: O(log B * K) worst case
+     * The last child whose separator is less than item (not greater than item, if upper)
+     */
+    int childByKey(Inner* inner, const T& item, bool upper = false) {
+        int left = 1, right = inner->size;
+        while (left < right) {
+            int middle = (left + right) / 2;
+            if (before(inner->keys[middle], item, upper))
+                left = middle + 1;
+            else
+                right = middle;
+        }
+        return left - 1;
+    }
+
+    /*
+     * Insert item into the subtree of node.
+     * If node splits, return its new right sibling and write its separator into separator.
+     */
+    Node* insert(Node* node, T& item, T& separator) {
+        if (node->isLeaf) {
+            Leaf* leaf = (Leaf*) node;
+            int position = boundInLeaf(leaf, item);
+
+            if (leaf->size < leafCapacity) {
+                for (int id = leaf->size; id > position; --id)
+                    leaf->keys[id] = std::move(leaf->keys[id - 1]);
+                leaf->keys[position] = std::move(item);
+                leaf->size++;
+                return nullptr;
+            }
+
+            // Split the leaf into two halves, then insert into one of them
+            Leaf* right = newLeaf();
+            int half = leafCapacity / 2;
+            for (int id = half; id < leafCapacity; ++id)
+                right->keys[id - half] = std::move(leaf->keys[id]);
+            right->size = leafCapacity - half;
+            leaf->size = half;
+
+            right->next = leaf->next;
+            right->prev = leaf;
+            if (leaf->next != nullptr)
+                leaf->next->prev = right;
+            else
+                last = right;
+            leaf->next = right;
+
+            if (position <= half)
+                insert(leaf, item, separator);
+            else
+                insert(right, item, separator);
+
+            separator = right->keys[0];
+            return right;
+        }
+
+        Inner* inner = (Inner*) node;
+        int c = childByKey(inner, item);
+        T childSeparator;
+        Node* split = insert(inner->children[c], item, childSeparator);
+        inner->counts[c]++;
+        if (split == nullptr)
+            return nullptr;
+
+        int splitCount = subtreeSize(split);
+        inner->counts[c] -= splitCount;
+
+        if (inner->size < innerCapacity) {
+            insertChild(inner, c + 1, split, splitCount, childSeparator);
+            return nullptr;
+        }
+
+        // Split the inner node into two halves, then insert the new child into one of them
+        Inner* right = newInner();
+        int half = innerCapacity / 2;
+        for (int id = half; id < innerCapacity; ++id) {
+            right->children[id - half] = inner->children[id];
+            right->counts[id - half] = inner->counts[id];
+            right->keys[id - half] = std::move(inner->keys[id]);
+        }
+        right->size = innerCapacity - half;
+        inner->size = half;
+
+        if (c + 1 <= half)
+            insertChild(inner, c + 1, split, splitCount, childSeparator);
+        else
+            insertChild(right, c + 1 - half, split, splitCount, childSeparator);
+
+        separator = right->keys[0];
+        return right;
+    }
+
+    // Time complexity: O(B) worst case. Put child into position c of inner node
+    void insertChild(Inner* inner, int c, Node* child, int count, T& key) {
+        for (int id = inner->size; id > c; --id) {
+            inner->children[id] = inner->children[id - 1];
+            inner->counts[id] = inner->counts[id - 1];
+            inner->keys[id] = std::move(inner->keys[id - 1]);
+        }
+        inner->children[c] = child;
+        inner->counts[c] = count;
+        inner->keys[c] = std::move(key);
+        inner->size++;
+    }
+
+    // Time complexity: O(B) worst case. Remove child from position c of inner node
+    void eraseChild(Inner* inner, int c) {
+        for (int id = c; id < inner->size - 1; ++id) {
+            inner->children[id] = inner->children[id + 1];
+            inner->counts[id] = inner->counts[id + 1];
+            inner->keys[id] = std::move(inner->keys[id + 1]);
+        }
+        inner->size--;
+    }
+
+    /*
+     * Remove the i-th (0-indexed) element of the subtree of node.
+     * Children which become less than half full are merged with or borrow from a sibling.
+     */
+    void removeAt(Node* node, int i) {
+        if (node->isLeaf) {
+            Leaf* leaf = (Leaf*) node;
+            for (int id = i; id < leaf->size - 1; ++id)
+                leaf->keys[id] = std::move(leaf->keys[id + 1]);
+            leaf->size--;
+            return;
+        }
+
+        Inner* inner = (Inner*) node;
+        int c = 0;
+        while (i >= inner->counts[c]) {
+            i -= inner->counts[c];
+            c++;
+        }
+
+        removeAt(inner->children[c], i);
+        inner->counts[c]--;
+
+        Node* child = inner->children[c];
+        int minSize = child->isLeaf ? leafCapacity / 2 : innerCapacity / 2;
+        if (child->size < minSize && inner->size > 1)
+            rebalance(inner, c + 1 < inner->size ? c : c - 1);
+    }
+
+    /*
+     * Time complexity: O(B) worst case
+     * Fix the children l and l + 1 of the inner node, one of which is underfull:
+     * merge them if they fit into one node, otherwise move one element (child) from the bigger one.
+     */
+    void rebalance(Inner* parent, int l) {
+        Node* leftNode = parent->children[l];
+        Node* rightNode = parent->children[l + 1];
+
+        if (leftNode->isLeaf) {
+            Leaf* left = (Leaf*) leftNode;
+            Leaf* right = (Leaf*) rightNode;
+
+            if (left->size + right->size <= leafCapacity) {
+                for (int id = 0; id < right->size; ++id)
+                    left->keys[left->size + id] = std::move(right->keys[id]);
+                left->size += right->size;
+
+                left->next = right->next;
+                if (right->next != nullptr)
+                    right->next->prev = left;
+                else
+                    last = left;
+                delete right;
+            } else if (left->size < right->size) {
+                left->keys[left->size++] = std::move(right->keys[0]);
+                for (int id = 0; id < right->size - 1; ++id)
+                    right->keys[id] = std::move(right->keys[id + 1]);
+                right->size--;
+                parent->keys[l + 1] = right->keys[0];
+                parent->counts[l]++;
+                parent->counts[l + 1]--;
+                return;
+            } else {
+                for (int id = right->size; id > 0; --id)
+                    right->keys[id] = std::move(right->keys[id - 1]);
+                right->keys[0] = std::move(left->keys[--left->size]);
+                right->size++;
+                parent->keys[l + 1] = right->keys[0];
+                parent->counts[l]--;
+                parent->counts[l + 1]++;
+                return;
+            }
+        } else {
+            Inner* left = (Inner*) leftNode;
+            Inner* right = (Inner*) rightNode;
+
+            if (left->size + right->size <= innerCapacity) {
+                right->keys[0] = parent->keys[l + 1];
+                for (int id = 0; id < right->size; ++id) {
+                    left->children[left->size + id] = right->children[id];
+                    left->counts[left->size + id] = right->counts[id];
+                    left->keys[left->size + id] = std::move(right->keys[id]);
+                }
+                left->size += right->size;
+                delete right;
+            } else if (left->size < right->size) {
+                int moved = right->counts[0];
+                left->children[left->size] = right->children[0];
+                left->counts[left->size] = moved;
+                left->keys[left->size] = parent->keys[l + 1];
+                left->size++;
+                parent->keys[l + 1] = right->keys[1];
+                eraseChild(right, 0);
+                parent->counts[l] += moved;
+                parent->counts[l + 1] -= moved;
+                return;
+            } else {
+                int moved = left->counts[left->size - 1];
+                right->keys[0] = parent->keys[l + 1];
+                T key = left->keys[left->size - 1];
+                insertChild(right, 0, left->children[left->size - 1], moved, key);
+                parent->keys[l + 1] = left->keys[left->size - 1];
+                left->size--;
+                parent->counts[l] -= moved;
+                parent->counts[l + 1] += moved;
+                return;
+            }
+        }
+
+        // Children were merged
+        parent->counts[l] += parent->counts[l + 1];
+        eraseChild(parent, l + 1);
+    }
+
+    /*
+     * Time complexity: O(log N * K) worst case
+     * Find the leaf and position of the first element which is not less than item
+     * (greater than item, if upper), write the number of elements before it into rank.
+     * If all elements go before the bound, return the last leaf and its size.
+     */
+    Leaf* seek(const T& item, bool upper, int& position, int& rank) {
+        rank = 0;
+        Node* node = root;
+        while (!node->isLeaf) {
+            Inner* inner = (Inner*) node;
+            int c = childByKey(inner, item, upper);
+            for (int id = 0; id < c; ++id)
+                rank += inner->counts[id];
+            node = inner->children[c];
+        }
+
+        Leaf* leaf = (Leaf*) node;
+        position = boundInLeaf(leaf, item, upper);
+        rank += position;
+        if (position == leaf->size && leaf->next != nullptr) {
+            // The first element of the next leaf is after the bound (see separators)
+            leaf = leaf->next;
+            position = 0;
+        }
+        return leaf;
+    }
+
+public:
+    /*
+     * Forward iterator over the linked leaves.
+     * Always points to an element or to the end (leaf == nullptr).
+     */
+    class Cursor {
+    private:
+        const Leaf* leaf;
+        int position;
+
+        void skipLeaf() {
+            if (leaf != nullptr && position == leaf->size) {
+                leaf = leaf->next;
+                position = 0;
+            }
+        }
+    public:
+        Cursor(const Leaf* leaf, int position) : leaf(leaf), position(position) {
+            skipLeaf();
+        }
+
+        const T& operator*() const {
+            return leaf->keys[position];
+        }
+
+        const T* operator->() const {
+            return &**this;
+        }
+
+        Cursor& operator++() {
+            position++;
+            skipLeaf();
+            return *this;
+        }
+
+        bool operator==(const Cursor& other) const {
+            return leaf == other.leaf && position == other.position;
+        }
+
+        bool operator!=(const Cursor& other) const {
+            return !(*this == other);
+        }
+    };
+
+    // Constructor
+    BPlusTreeSortedList() {
+        first = last = newLeaf();
+        root = first;
+        numberOfElements = 0;
+    }
+
+    ~BPlusTreeSortedList() {
+        destroy(root);
+    }
+
+    BPlusTreeSortedList(const BPlusTreeSortedList&) = delete;
+    BPlusTreeSortedList& operator=(const BPlusTreeSortedList&) = delete;
+
+    /*
+     * Time complexity: O(log N * K) worst case
+     * K - number of iterations for comparing the objects.
+     *
+     * Descend by separators to the leaf, insert into its sorted array: O(B).
+     * If the leaf is full, split it and propagate the split to the parents,
+     * every split takes O(B). The height of the tree is O(log N).
+     */
+    void add(T item) override {
+        T separator;
+        Node* split = insert(root, item, separator);
+        if (split != nullptr) {
+            Inner* newRoot = newInner();
+            T unused = T();
+            int splitCount = subtreeSize(split);
+            insertChild(newRoot, 0, root, numberOfElements + 1 - splitCount, unused);
+            insertChild(newRoot, 1, split, splitCount, separator);
+            root = newRoot;
+        }
+        numberOfElements++;
+    }
+
+    /*
+     * Time complexity: O(1) worst case
+     * The least element is the first element of the leftmost leaf.
+     */
+    T least() override {
+        if (numberOfElements == 0) {
+            cout << "There are no elements in the tree." << endl;
+            return T();
+        }
+        return first->keys[0];
+    }
+
+    /*
+     * Time complexity: O(1) worst case
+     * The greatest element is the last element of the rightmost leaf.
+     */
+    T greatest() override {
+        if (numberOfElements == 0) {
+            cout << "There are no elements in the tree." << endl;
+            return T();
+        }
+        return last->keys[last->size - 1];
+    }
+
+    /*
+     * Time complexity: O(log N) worst case
+     * Descend by the subtree counts: O(B) per level, O(log N) levels.
+     */
+    T get(int i) override {
+        if (i <= 0 || i > numberOfElements) {
+            cout << "There are no " << i << "th element in the tree." << endl;
+            cout << "Returning the least element." << endl;
+            return least();
+        }
+
+        i--;
+        Node* node = root;
+        while (!node->isLeaf) {
+            Inner* inner = (Inner*) node;
+            int c = 0;
+            while (i >= inner->counts[c]) {
+                i -= inner->counts[c];
+                c++;
+            }
+            node = inner->children[c];
+        }
+        return ((Leaf*) node)->keys[i];
+    }
+
+    /*
+     * Time complexity: O(log N * K) worst case
+     * Descend by separators, summing up the counts of the skipped children.
+     */
+    int lowerBound(const T& item) override {
+        int position, rank;
+        seek(item, false, position, rank);
+        return rank;
+    }
+
+    /*
+     * Time complexity: O(log N * K) worst case
+     * Same as lowerBound, but skips the elements equal to item.
+     */
+    int upperBound(const T& item) override {
+        int position, rank;
+        seek(item, true, position, rank);
+        return rank;
+    }
+
+    /*
+     * Time complexity: O(log N * K) worst case
+     * Same descent as in lowerBound.
+     */
+    int indexOf(T item) override {
+        int position, rank;
+        Leaf* leaf = seek(item, false, position, rank);
+
+        if (position == leaf->size || !(leaf->keys[position] == item)) {
+            cout << item << " is not in the BPlusTreeSortedList." << endl;
+            cout << "Returning id of the least element." << endl;
+            return 0;
+        }
+        return rank;
+    }
+
+    /*
+     * Time complexity: O(log N) worst case
+     * Descend by the subtree counts, remove from the leaf, then on the way up
+     * merge or rebalance the underfull nodes: O(B) per level.
+     */
+    void remove(int i) override {
+        if (i <= 0 || i > numberOfElements) {
+            cout << "There are no " << i << "th element in the tree." << endl;
+            return;
+        }
+
+        removeAt(root, i - 1);
+        numberOfElements--;
+
+        if (!root->isLeaf && root->size == 1) {
+            Inner* oldRoot = (Inner*) root;
+            root = oldRoot->children[0];
+            delete oldRoot;
+        }
+    }
+
+    /*
+     * Time complexity: O(log N * K + M) worst case
+     * M - number of found elements.
+     *
+     * Find the first element which is not less than from,
+     * then walk through the linked leaves until the element is greater than to.
+     */
+    List<T> searchRange(T from, T to) override {
+        List<T> lst;
+
+        int position, rank;
+        for (Leaf* leaf = seek(from, false, position, rank); leaf != nullptr; leaf = leaf->next, position = 0) {
+            for (; position < leaf->size; ++position) {
+                if (to < leaf->keys[position])
+                    return lst;
+                lst.push(leaf->keys[position]);
+            }
+        }
+
+        return lst;
+    }
+
+    /*
+     * Time complexity: O(log N * K) worst case
+     * Cursors to the lower bound of from and to the upper bound of to.
+     * Nothing is copied, the elements are read from the leaves while iterating.
+     */
+    SortedRange<Cursor> range(T from, T to) {
+        int firstPosition, lastPosition, rank;
+        Leaf* firstLeaf = seek(from, false, firstPosition, rank);
+        Cursor first(firstLeaf, firstPosition);
+        if (to < from)
+            return SortedRange<Cursor>(first, first);
+
+        Leaf* lastLeaf = seek(to, true, lastPosition, rank);
+        return SortedRange<Cursor>(first, Cursor(lastLeaf, lastPosition));
+    }
+
+    /*
+     * Time complexity: O(1) worst case
+     */
+    int size() override {
+        return numberOfElements;
+    }
+
+    /*
+     * Time complexity: O(1) worst case
+     */
+    bool isEmpty() override {
+        return numberOfElements == 0;
+    }
+};
+
+/*
+ * Concurrent Sorted List on top of a lazy skip list.
+ *
+ * Several threads may add and remove elements while other threads read them.
+ *  - Writers lock only the predecessors of the changed node (fine-grained locking)
+ *    and validate that nothing changed between the search and the locking.
+ *  - Removal is lazy: the node is first marked (logically removed, this is the
+ *    linearization point), then unlinked from all levels.
+ *  - Readers never lock: they walk the next pointers and skip the nodes which are
+ *    marked or not fully linked yet, so searchRange and range iteration are wait-free.
+ *
+ * Equal elements are allowed: nodes are ordered by (element, insertion order).
+ *
+ * Removed nodes may still be visited by concurrent readers, so they are not freed
+ * right away, but kept until reclaim() is called at a moment when no other thread
+ * uses the list (or until the list is destroyed).
+ *
+ * Rank operations (get, indexOf, remove(i), lowerBound, upperBound) have to count
+ * the nodes one by one, they take O(N). Search by element takes O(log N) expected.
+ */
+template <typename T>
+class ConcurrentSkipList : SortedList <T> {
+private:
+    static const int maxLevel = 24; // enough for 2^24 elements with probability 1/2 per level
+
+    struct Node {
+        T key;
+        unsigned long long order; // insertion order, breaks ties between equal keys
+        int topLevel;
+        int kind; // -1 for head, 1 for tail, 0 for a node with an element
+        atomic<bool> marked; // logically removed
+        atomic<bool> fullyLinked; // linked on all its levels
+        mutex lock;
+        atomic<Node*>* next;
+
+        Node(T key, unsigned long long order, int topLevel, int kind)
+            : key(std::move(key)), order(order), topLevel(topLevel), kind(kind), marked(false), fullyLinked(false) {
+            next = new atomic<Node*>[topLevel + 1];
+            for (int level = 0; level <= topLevel; ++level)
+                next[level] = nullptr;
+        }
+
+        ~Node() {
+            delete [] next;
+        }
+
+        bool isAlive() const {
+            return kind == 0 && fullyLinked && !marked;
+        }
+    };
+
+    Node* head;
+    Node* tail;
+    atomic<unsigned long long> nextOrder;
+    atomic<int> numberOfElements;
+
+    mutex retiredLock;
+    vector<Node*> retired; // unlinked nodes, freed in reclaim()
+
+    // Level of a new node: level L with probability 1 / 2^(L + 1)
+    static int randomLevel() {
+        static atomic<unsigned long long> seeds(0x9E3779B97F4A7C15ULL);
+        thread_local unsigned long long state = seeds.fetch_add(0x9E3779B97F4A7C15ULL) | 1;
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        int level = __builtin_ctzll(state | (1ULL << (maxLevel - 1)));
+        return level;
+    }
+
+    // Whether the node goes before (key, order)
+    static bool before(const Node* node, const T& key, unsigned long long order) {
+        if (node->kind != 0)
+            return node->kind < 0;
+        if (node->key < key)
+            return true;
+        if (key < node->key)
+            return false;
+        return node->order < order;
+    }
+
+    /*
+     * Time complexity: O(log N) expected
+     * For every level find the last node before (key, order) and the node after it.
+     * Does not lock anything.
+     */
+    void find(const T& key, unsigned long long order, Node** preds, Node** succs) {
+        Node* pred = head;
+        for (int level = maxLevel - 1; level >= 0; --level) {
+            Node* current = pred->next[level];
+            while (before(current, key, order)) {
+                pred = current;
+                current = pred->next[level];
+            }
+            preds[level] = pred;
+            succs[level] = current;
+        }
+    }
+
+    /*
+     * Lock the predecessors of the levels [0, topLevel].
+     * The same node may be the predecessor on several neighbouring levels, it is locked once.
+     * Locks are always taken from the right to the left, so there are no deadlocks.
+     */
+    static void lockPredecessors(Node** preds, int topLevel) {
+        for (int level = 0; level <= topLevel; ++level)
+            if (level == 0 || preds[level] != preds[level - 1])
+                preds[level]->lock.lock();
+    }
+
+    static void unlockPredecessors(Node** preds, int topLevel) {
+        for (int level = 0; level <= topLevel; ++level)
+            if (level == 0 || preds[level] != preds[level - 1])
+                preds[level]->lock.unlock();
+    }
+
+    /*
+     * Time complexity: O(log N) expected
+     * Mark the node and unlink it from all its levels.
+     * Returns false if another thread has removed it first.
+     */
+    bool removeNode(Node* victim) {
+        {
+            lock_guard<mutex> guard(victim->lock);
+            if (victim->marked)
+                return false;
+            victim->marked = true;
+        }
+        numberOfElements--;
+
+        Node* preds[maxLevel];
+        Node* succs[maxLevel];
+        while (true) {
+            find(victim->key, victim->order, preds, succs);
+            lockPredecessors(preds, victim->topLevel);
+
+            bool valid = true;
+            for (int level = 0; valid && level <= victim->topLevel; ++level)
+                valid = !preds[level]->marked && preds[level]->next[level] == victim;
+
+            if (valid) {
+                for (int level = victim->topLevel; level >= 0; --level)
+                    preds[level]->next[level] = victim->next[level].load();
+                unlockPredecessors(preds, victim->topLevel);
+                break;
+            }
+            unlockPredecessors(preds, victim->topLevel);
+        }
+
+        lock_guard<mutex> guard(retiredLock);
+        retired.push_back(victim);
+        return true;
+    }
+
+    /*
+     * Time complexity: O(log N) expected
+     * The first alive node which does not go before (key, order), or tail.
+     */
+    Node* firstFrom(const T& key, unsigned long long order) {
+        Node* preds[maxLevel];
+        Node* succs[maxLevel];
+        find(key, order, preds, succs);
+
+        Node* node = succs[0];
+        while (node->kind == 0 && !node->isAlive())
+            node = node->next[0];
+        return node;
+    }
+
+    // Time complexity: O(N) worst case. The i-th (1-indexed) alive node, or tail
+    Node* nodeAt(int i) {
+        Node* node = head->next[0];
+        for (; node->kind == 0; node = node->next[0])
+            if (node->isAlive() && --i == 0)
+                break;
+        return node;
+    }
+
+    // Time complexity: O(N) worst case. Number of alive nodes before (key, order)
+    int countBefore(const T& key, unsigned long long order) {
+        int count = 0;
+        for (Node* node = head->next[0]; before(node, key, order); node = node->next[0])
+            count += node->isAlive();
+        return count;
+    }
+
+public:
+    /*
+     * Forward iterator over the alive nodes up to the element to (inclusive).
+     * Becomes equal to the end (node == nullptr) after the last such node.
+     */
+    class Cursor {
+    private:
+        Node* node;
+        T to;
+
+        void skip() {
+            while (node != nullptr && node->kind == 0 && !node->isAlive())
+                node = node->next[0];
+            if (node != nullptr && (node->kind != 0 || to < node->key))
+                node = nullptr;
+        }
+    public:
+        Cursor(Node* node, T to) : node(node), to(std::move(to)) {
+            skip();
+        }
+
+        const T& operator*() const {
+            return node->key;
+        }
+
+        const T* operator->() const {
+            return &node->key;
+        }
+
+        Cursor& operator++() {
+            node = node->next[0];
+            skip();
+            return *this;
+        }
+
+        bool operator==(const Cursor& other) const {
+            return node == other.node;
+        }
+
+        bool operator!=(const Cursor& other) const {
+            return node != other.node;
+        }
+    };
+
+    // Constructor
+    ConcurrentSkipList() : nextOrder(1), numberOfElements(0) {
+        head = new Node(T(), 0, maxLevel - 1, -1);
+        tail = new Node(T(), 0, maxLevel - 1, 1);
+        for (int level = 0; level < maxLevel; ++level)
+            head->next[level] = tail;
+        head->fullyLinked = tail->fullyLinked = true;
+    }
+
+    ~ConcurrentSkipList() {
+        reclaim();
+        Node* node = head;
+        while (node != nullptr) {
+            Node* next = node->next[0];
+            delete node;
+            node = next;
+        }
+    }
+
+    ConcurrentSkipList(const ConcurrentSkipList&) = delete;
+    ConcurrentSkipList& operator=(const ConcurrentSkipList&) = delete;
+
+    /*
+     * Time complexity: O(log N) expected
+     * Find the predecessors on all levels of the new node, lock them, check that
+     * they are still alive and still point to the found successors, then link
+     * the node bottom-up. If the check fails, another writer got there first: retry.
+     */
+    void add(T item) override {
+        int topLevel = randomLevel();
+        unsigned long long order = nextOrder++;
+
+        Node* preds[maxLevel];
+        Node* succs[maxLevel];
+        while (true) {
+            find(item, order, preds, succs);
+            lockPredecessors(preds, topLevel);
+
+            bool valid = true;
+            for (int level = 0; valid && level <= topLevel; ++level)
+                valid = !preds[level]->marked && !succs[level]->marked && preds[level]->next[level] == succs[level];
+
+            if (valid) {
+                Node* node = new Node(std::move(item), order, topLevel, 0);
+                for (int level = 0; level <= topLevel; ++level)
+                    node->next[level] = succs[level];
+                for (int level = 0; level <= topLevel; ++level)
+                    preds[level]->next[level] = node;
+                node->fullyLinked = true;
+                numberOfElements++;
+
+                unlockPredecessors(preds, topLevel);
+                return;
+            }
+            unlockPredecessors(preds, topLevel);
+        }
+    }
+
+    /*
+     * Time complexity: O(log N) expected
+     * Remove one occurrence of item. Returns false if there is no such element.
+     */
+    bool removeItem(const T& item) {
+        while (true) {
+            Node* node = firstFrom(item, 0);
+            if (node->kind != 0 || item < node->key)
+                return false;
+            if (removeNode(node))
+                return true;
+        }
+    }
+
+    /*
+     * Time complexity: O(1), if the first nodes are not removed
+     * The least element is the first alive node of the bottom level.
+     */
+    T least() override {
+        Node* node = nodeAt(1);
+        if (node->kind != 0) {
+            cout << "There are no elements in the list." << endl;
+            return T();
+        }
+        return node->key;
+    }
+
+    /*
+     * Time complexity: O(log N) expected
+     * Go to the last node of every level, then look for the last alive node at the bottom level.
+     */
+    T greatest() override {
+        Node* node = head;
+        for (int level = maxLevel - 1; level > 0; --level)
+            while (node->next[level].load()->kind == 0)
+                node = node->next[level];
+
+        Node* last = nullptr;
+        for (; node->kind != 1; node = node->next[0])
+            if (node->isAlive())
+                last = node;
+
+        if (last == nullptr) {
+            // The nodes after the start were removed, look through the whole list
+            for (node = head->next[0]; node->kind == 0; node = node->next[0])
+                if (node->isAlive())
+                    last = node;
+        }
+        if (last == nullptr) {
+            cout << "There are no elements in the list." << endl;
+            return T();
+        }
+        return last->key;
+    }
+
+    /*
+     * Time complexity: O(N) worst case
+     * Skip lists do not know the ranks, so we count the nodes.
+     */
+    T get(int i) override {
+        Node* node = i <= 0 ? tail : nodeAt(i);
+        if (node->kind != 0) {
+            cout << "There are no " << i << "th element in the list." << endl;
+            cout << "Returning the least element." << endl;
+            return least();
+        }
+        return node->key;
+    }
+
+    /*
+     * Time complexity: O(N) worst case
+     */
+    int indexOf(T item) override {
+        Node* node = firstFrom(item, 0);
+        if (node->kind != 0 || item < node->key) {
+            cout << item << " is not in the ConcurrentSkipList." << endl;
+            cout << "Returning id of the least element." << endl;
+            return 0;
+        }
+        return countBefore(item, 0);
+    }
+
+    // Time complexity: O(N) worst case
+    int lowerBound(const T& item) override {
+        return countBefore(item, 0);
+    }
+
+    // Time complexity: O(N) worst case
+    int upperBound(const T& item) override {
+        return countBefore(item, ~0ULL);
+    }
+
+    /*
+     * Time complexity: O(N) worst case
+     * Find the i-th alive node and remove it. If another thread removes it first, look again.
+     */
+    void remove(int i) override {
+        while (true) {
+            Node* node = i <= 0 ? tail : nodeAt(i);
+            if (node->kind != 0) {
+                cout << "There are no " << i << "th element in the list." << endl;
+                return;
+            }
+            if (removeNode(node))
+                return;
+        }
+    }
+
+    /*
+     * Time complexity: O(log N + M) expected
+     * Wait-free: descend to the first element which is not less than from,
+     * then walk through the bottom level, skipping the removed nodes.
+     */
+    List<T> searchRange(T from, T to) override {
+        List<T> lst;
+        for (const T& element : range(from, to))
+            lst.push(element);
+        return lst;
+    }
+
+    /*
+     * Time complexity: O(log N) expected
+     * Elements are read from the nodes while iterating.
+     */
+    SortedRange<Cursor> range(T from, T to) {
+        if (to < from)
+            return SortedRange<Cursor>(Cursor(nullptr, to), Cursor(nullptr, to));
+        Node* first = firstFrom(from, 0);
+        return SortedRange<Cursor>(Cursor(first, to), Cursor(nullptr, to));
+    }
+
+    /*
+     * Time complexity: O(1) worst case
+     * Removed elements are not counted right after they are marked.
+     */
+    int size() override {
+        return numberOfElements;
+    }
+
+    bool isEmpty() override {
+        return numberOfElements == 0;
+    }
+
+    /*
+     * Time complexity: O(R), R - number of removed nodes
+     * Free the removed nodes. Call it only when no other thread uses the list.
+     */
+    void reclaim() {
+        lock_guard<mutex> guard(retiredLock);
+        for (Node* node : retired)
+            delete node;
+        retired.clear();
+    }
+};
+
+/*
+ * Multi-threaded stress test and throughput benchmark of ConcurrentSkipList.
+ *
+ * For every number of threads (1, 2, 4, ... up to maxThreads) half of the threads
+ * (at least one) are writers, the rest are readers:
+ *  - writer w adds random keys with key % 64 == w and removes random keys it has added,
+ *    so every writer knows exactly which of its keys must stay in the list;
+ *  - reader scans random ranges and checks that they are sorted.
+ * In the end the list must contain exactly the keys which writers kept.
+ *
+ * Prints the throughput of updates and range scans, returns 1 if a check fails.
+ */
+int skipListStress(int maxThreads, int operationsPerWriter) {
+    if (maxThreads < 1)
+        maxThreads = 1;
+    if (maxThreads > 64)
+        maxThreads = 64;
+
+    bool failed = false;
+    for (int threads = 1; ; threads = min(threads * 2, maxThreads)) {
+        int writers = threads - threads / 2;
+        int readers = threads / 2;
+
+        ConcurrentSkipList<long long> list;
+        vector<vector<long long>> kept(writers);
+        atomic<int> writersLeft(writers);
+        atomic<long long> scans(0);
+        atomic<bool> sorted(true);
+
+        auto start = chrono::steady_clock::now();
+        vector<thread> workers;
+        for (int w = 0; w < writers; ++w) {
+            workers.emplace_back([&, w] {
+                mt19937_64 random(w + 1);
+                vector<long long>& keys = kept[w];
+                for (int op = 0; op < operationsPerWriter; ++op) {
+                    if (keys.empty() || random() % 5 < 3) {
+                        long long key = (long long) (random() % 1000000) * 64 + w;
+                        list.add(key);
+                        keys.push_back(key);
+                    } else {
+                        size_t id = random() % keys.size();
+                        if (!list.removeItem(keys[id]))
+                            sorted = false;
+                        keys[id] = keys.back();
+                        keys.pop_back();
+                    }
+                }
+                writersLeft--;
+            });
+        }
+        for (int r = 0; r < readers; ++r) {
+            workers.emplace_back([&, r] {
+                mt19937_64 random(1000 + r);
+                while (writersLeft > 0) {
+                    long long from = (long long) (random() % 1000000) * 64;
+                    long long previous = from;
+                    for (long long key : list.range(from, from + 64 * 1000)) {
+                        if (key < previous)
+                            sorted = false;
+                        previous = key;
+                    }
+                    scans++;
+                }
+            });
+        }
+        for (thread& worker : workers)
+            worker.join();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        // Check the final contents
+        vector<long long> expected;
+        for (vector<long long>& keys : kept)
+            expected.insert(expected.end(), keys.begin(), keys.end());
+        sort(expected.begin(), expected.end());
+
+        vector<long long> actual;
+        for (long long key : list.range(LLONG_MIN, LLONG_MAX))
+            actual.push_back(key);
+
+        bool ok = sorted && actual == expected && list.size() == (int) expected.size();
+        failed |= !ok;
+
+        cout << fixed << setprecision(0);
+        cout << "threads " << threads << " (writers " << writers << ", readers " << readers << "): "
+             << writers * (double) operationsPerWriter / seconds << " updates/s, "
+             << scans / seconds << " scans/s, " << (ok ? "OK" : "FAILED") << endl;
+
+        if (threads == maxThreads)
+            break;
+    }
+    return failed ? 1 : 0;
+}
+
+/*
+ * Benchmark of the SortedList implementations.
+ *
+ * Heap allocations go through the operator new below, so the benchmark reports
+ * allocations per operation for any container without changing it. It counts only
+ * when countHeapAllocations is set (by the bench mode), other modes are not affected.
+ *
+ * Peak RSS only grows during a process, so every list is measured in its own child
+ * process (see runInChildProcess): its peak is the list plus the keys of the size,
+ * which are the same for all the lists, and not the lists measured before.
+ */
+static atomic<bool> countHeapAllocations(false);
+static atomic<long long> heapAllocations(0);
+static volatile long long benchmarkSink; // results of the measured calls, so they are not optimized away
+
+void* operator new(size_t bytes) {
+    if (countHeapAllocations.load(memory_order_relaxed))
+        heapAllocations.fetch_add(1, memory_order_relaxed);
+    if (void* pointer = malloc(bytes == 0 ? 1 : bytes))
+        return pointer;
+    throw bad_alloc();
+}
+
+// free is the right pair for this operator new; GCC warns when delete is inlined into a caller
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    free(pointer);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+long peakResidentKilobytes() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/*
+ * Run body in a child process and wait for it. The peak RSS of a new process
+ * starts from its current RSS, so the lists measured before do not count.
+ * If fork fails, body runs in this process.
+ */
+template <typename Body>
+void runInChildProcess(Body body) {
+    cout.flush();
+    pid_t child = fork();
+    if (child == 0) {
+        body();
+        cout.flush();
+        _exit(0);
+    }
+    if (child < 0)
+        body();
+    else
+        waitpid(child, nullptr, 0);
+}
+
+template <typename T>
+T benchmarkKey(mt19937_64& random);
+
+template <>
+int benchmarkKey<int>(mt19937_64& random) {
+    return (int) random();
+}
+
+template <>
+double benchmarkKey<double>(mt19937_64& random) {
+    return (double) (random() % 100000000) / 100;
+}
+
+template <>
+string benchmarkKey<string>(mt19937_64& random) {
+    string key(16, 'a'); // longer than the small string buffer
+    for (char& symbol : key)
+        symbol = (char) ('a' + random() % 26);
+    return key;
+}
+
+template <>
+pair<double, string> benchmarkKey<pair<double, string>>(mt19937_64& random) {
+    return make_pair(benchmarkKey<double>(random), benchmarkKey<string>(random));
+}
+
+/*
+ * Runs operations timed calls of body(op) and prints one line of the report.
+ */
+template <typename Body>
+void benchmarkOperation(const string& title, const char* operation, const char* order, int operations, Body body) {
+    long long allocations = heapAllocations.load();
+    auto start = chrono::steady_clock::now();
+    for (int op = 0; op < operations; ++op)
+        body(op);
+    double nanoseconds = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    allocations = heapAllocations.load() - allocations;
+
+    cout << left << setw(52) << title << setw(12) << operation << setw(12) << order << right
+         << fixed << setprecision(1) << setw(14) << nanoseconds / operations
+         << setprecision(2) << setw(12) << (double) allocations / operations
+         << setw(12) << peakResidentKilobytes() << endl;
+}
+
+/*
+ * Time complexity: depends on the implementation, O(n log n) list builds plus
+ * 'operations' measured calls of every operation.
+ *
+ * Builds a list of n elements (adding them in ascending order, which is cheap for
+ * all implementations) and measures at that size:
+ *   - add of new keys in random, ascending (greater than all) and descending (less than all) order
+ *   - get, indexOf and searchRange of about 10 elements after the random adds
+ *   - remove of random positions
+ * To measure a new implementation, add a line to benchmarkKeyType.
+ */
+template <typename ListType, typename T>
+void benchmarkList(const string& name, const string& keyName, const vector<T>& sortedKeys, int n, int operations) {
+    string title = name + " <" + keyName + "> n=" + to_string(n);
+    mt19937_64 random(n);
+
+    const char* orders[] = {"random", "ascending", "descending"};
+    for (int order = 2; order >= 0; --order) {
+        vector<T> base, added;
+        if (order == 0) {
+            vector<T> keys(sortedKeys);
+            shuffle(keys.begin(), keys.end(), random);
+            base.assign(keys.begin(), keys.begin() + n);
+            sort(base.begin(), base.end());
+            added.assign(keys.begin() + n, keys.end());
+        } else if (order == 1) {
+            base.assign(sortedKeys.begin(), sortedKeys.begin() + n);
+            added.assign(sortedKeys.begin() + n, sortedKeys.end());
+        } else {
+            base.assign(sortedKeys.begin() + operations, sortedKeys.end());
+            added.assign(sortedKeys.rbegin() + n, sortedKeys.rend());
+        }
+
+        ListType list;
+        for (T& key : base)
+            list.add(std::move(key));
+
+        benchmarkOperation(title, "add", orders[order], operations, [&](int op) {
+            list.add(added[op]);
+        });
+        if (order != 0)
+            continue;
+
+        int size = list.size();
+        vector<int> positions(operations);
+        for (int& position : positions)
+            position = (int) (random() % size) + 1;
+
+        long long checksum = 0;
+        benchmarkOperation(title, "get", "random", operations, [&](int op) {
+            checksum += list.get(positions[op]) < sortedKeys[0];
+        });
+        benchmarkOperation(title, "indexOf", "random", operations, [&](int op) {
+            checksum += list.indexOf(added[op]);
+        });
+        benchmarkOperation(title, "searchRange", "random", operations, [&](int op) {
+            int from = max(0, min(positions[op] - 1, size - 11));
+            checksum += list.searchRange(sortedKeys[from], sortedKeys[from + 10]).size();
+        });
+        benchmarkOperation(title, "remove", "random", operations, [&](int op) {
+            list.remove(positions[op] - op > 0 ? positions[op] - op : 1);
+        });
+        benchmarkSink = checksum;
+    }
+}
+
+template <typename T>
+void benchmarkKeyType(const string& keyName, int minSize, int maxSize, int maxOperations) {
+    for (long long n = minSize; n <= maxSize; n *= 10) {
+        int operations = (int) min<long long>(n, maxOperations);
+
+        mt19937_64 random(12345);
+        vector<T> sortedKeys;
+        sortedKeys.reserve(n + operations);
+        for (long long id = 0; id < n + operations; ++id)
+            sortedKeys.push_back(benchmarkKey<T>(random));
+        sort(sortedKeys.begin(), sortedKeys.end());
+
+        runInChildProcess([&] {
+            benchmarkList<ArraySortedList<T>>("ArraySortedList", keyName, sortedKeys, (int) n, operations);
+        });
+        runInChildProcess([&] {
+            benchmarkList<SmallSortedList<T, 32>>("SmallSortedList<32>", keyName, sortedKeys, (int) n, operations);
+        });
+        runInChildProcess([&] {
+            benchmarkList<PackedSortedList<T>>("PackedSortedList", keyName, sortedKeys, (int) n, operations);
+        });
+        runInChildProcess([&] {
+            benchmarkList<BPlusTreeSortedList<T>>("BPlusTreeSortedList", keyName, sortedKeys, (int) n, operations);
+        });
+        runInChildProcess([&] {
+            benchmarkList<ConcurrentSkipList<T>>("ConcurrentSkipList", keyName, sortedKeys, (int) n, operations);
+        });
+    }
+}
+
+/*
+ * bench [min size] [max size] [operations]
+ * Sizes go through the powers of ten between min and max size.
+ * get and indexOf of ConcurrentSkipList take O(N), so big sizes take long.
+ */
+int sortedListBenchmark(int minSize, int maxSize, int maxOperations) {
+    countHeapAllocations = true;
+    cout << left << setw(52) << "list" << setw(12) << "operation" << setw(12) << "order" << right
+         << setw(14) << "ns/op" << setw(12) << "allocs/op" << setw(12) << "peak KB" << endl;
+    benchmarkKeyType<int>("int", minSize, maxSize, maxOperations);
+    benchmarkKeyType<double>("double", minSize, maxSize, maxOperations);
+    benchmarkKeyType<string>("string", minSize, maxSize, maxOperations);
+    benchmarkKeyType<pair<double, string>>("pair<double,string>", minSize, maxSize, maxOperations);
+    return 0;
+}
+
+/*
+ * Checks of the allocation resources (main allocator-check):
+ *  - an object aligned stronger than a size class gets its alignment from Pool,
+ *    and after deallocate its block is not reused by a size class (it is smaller
+ *    than the class, so the next chunk of the class would overflow it);
+ *  - a returned chunk is reused by the next request of its size class;
+ *  - Arena keeps the alignment of every request.
+ * Prints one line per check, returns 1 if a check fails.
+ */
+int allocatorCheck() {
+    bool failed = false;
+    auto check = [&](const char* title, bool ok) {
+        cout << title << ": " << (ok ? "OK" : "FAILED") << endl;
+        failed |= !ok;
+    };
+
+    struct alignas(32) OverAligned {
+        char data[96];
+    };
+
+    {
+        Pool pool;
+        PoolAllocator<OverAligned> overAligned(&pool);
+        PoolAllocator<char> bytes(&pool);
+
+        OverAligned* object = overAligned.allocate(1);
+        check("pool, over-aligned object is aligned", (size_t) object % alignof(OverAligned) == 0);
+        memset(object, 1, sizeof(OverAligned));
+        overAligned.deallocate(object, 1);
+
+        char* chunk = bytes.allocate(128);
+        memset(chunk, 2, 128);
+        check("pool, over-aligned block is not reused by a size class", (void*) chunk != (void*) object);
+
+        bytes.deallocate(chunk, 128);
+        char* again = bytes.allocate(100);
+        check("pool, returned chunk is reused by its size class", again == chunk);
+        bytes.deallocate(again, 100);
+    }
+
+    {
+        Arena arena(256);
+        ArenaAllocator<char> bytes(&arena);
+        ArenaAllocator<OverAligned> overAligned(&arena);
+        bool aligned = true;
+        for (int id = 0; id < 100; ++id) {
+            bytes.allocate(1 + id % 7);
+            aligned &= (size_t) overAligned.allocate(1 + id % 3) % alignof(OverAligned) == 0;
+        }
+        check("arena, every request is aligned", aligned);
+    }
+
+    return failed ? 1 : 0;
+}
+
+int main(int argc, char* argv[]) {
+    // allocator-check: see allocatorCheck
+    if (argc > 1 && string(argv[1]) == "allocator-check")
+        return allocatorCheck();
+
+    // skiplist-stress [max threads] [operations per writer]
+    if (argc > 1 && string(argv[1]) == "skiplist-stress") {
+        int maxThreads = argc > 2 ? stoi(argv[2]) : (int) thread::hardware_concurrency();
+        int operations = argc > 3 ? stoi(argv[3]) : 200000;
+        return skipListStress(maxThreads, operations);
+    }
+
+    // bench [min size] [max size] [operations per measurement]
+    if (argc > 1 && string(argv[1]) == "bench") {
+        int minSize = argc > 2 ? stoi(argv[2]) : 1000;
+        int maxSize = argc > 3 ? stoi(argv[3]) : 100000;
+        int operations = argc > 4 ? stoi(argv[4]) : 1000;
+        return sortedListBenchmark(minSize, maxSize, operations);
+    }
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,227 @@
+//
+// 2.2 Managing Pawn Shop Items
+// Load generator: command streams for 2.2_ManagingPawnShopItems
+//
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <cstdint>
+
+using namespace std;
+
+/*
+ * The stream is valid for the sequential semantics: REMOVE always takes
+ * an item which is in the inventory at that moment.
+ */
+const char* usage =
+    "Usage:\n"
+    "  2.2_LoadGenerator [options] > commands.txt\n"
+    "  2.2_ManagingPawnShopItems --latency < commands.txt > /dev/null\n"
+    "\n"
+    "Options:\n"
+    "  --commands N            number of commands (default 100000)\n"
+    "  --mix A:R:L[:C:S]       weights of ADD, REMOVE, LIST, COUNT, SUM (default 60:30:10)\n"
+    "  --prices KIND           uniform | zipf | clustered (default uniform)\n"
+    "  --max-price P           prices are in [0, P] dollars (default 1000)\n"
+    "  --zipf-s S              exponent of the Zipf distribution (default 1.1)\n"
+    "  --clusters K            number of price clusters (default 8)\n"
+    "  --width W               LIST, COUNT and SUM ranges are up to W dollars wide (default 10)\n"
+    "  --names K               number of different item names (default 100)\n"
+    "  --seed X                seed of the random generator (default 1)\n";
+
+struct Options {
+    long long commands = 100000;
+    vector<double> mix = {60, 30, 10, 0, 0};
+    string prices = "uniform";
+    double maxPrice = 1000;
+    double zipfS = 1.1;
+    int clusters = 8;
+    double width = 10;
+    int names = 100;
+    unsigned long long seed = 1;
+};
+
+/*
+ * Prices in cents of the chosen distribution.
+ *   uniform   - every cent in [0, maxPrice] is equally likely
+ *   zipf      - 10000 fixed price points, the k-th most popular has probability ~ 1 / k^s
+ *   clustered - normal distributions around a few random centers
+ */
+class PriceDistribution {
+private:
+    const Options& options;
+    long long maxCents;
+    vector<long long> points; // zipf: price points by popularity
+    vector<double> cumulative; // zipf: cumulative probabilities of the points
+    vector<long long> centers; // clustered: centers of the clusters
+
+public:
+    PriceDistribution(const Options& options, mt19937_64& random) : options(options) {
+        maxCents = (long long) llround(options.maxPrice * 100);
+
+        if (options.prices == "zipf") {
+            const int pointCount = 10000;
+            double total = 0;
+            for (int rank = 1; rank <= pointCount; ++rank) {
+                points.push_back(random() % (maxCents + 1));
+                total += 1 / pow(rank, options.zipfS);
+                cumulative.push_back(total);
+            }
+            for (double& value : cumulative)
+                value /= total;
+        } else if (options.prices == "clustered") {
+            for (int id = 0; id < max(options.clusters, 1); ++id)
+                centers.push_back(random() % (maxCents + 1));
+        }
+    }
+
+    long long next(mt19937_64& random) {
+        if (!points.empty()) {
+            double u = uniform_real_distribution<double>(0, 1)(random);
+            size_t rank = lower_bound(cumulative.begin(), cumulative.end(), u) - cumulative.begin();
+            return points[min(rank, points.size() - 1)];
+        }
+        if (!centers.empty()) {
+            long long center = centers[random() % centers.size()];
+            normal_distribution<double> spread((double) center, maxCents / 100.0 + 1);
+            return min(max((long long) llround(spread(random)), 0LL), maxCents);
+        }
+        return random() % (maxCents + 1);
+    }
+};
+
+/*
+ * Whole text must be a number, otherwise false (strtod and strtoll accept a prefix).
+ */
+bool parseNumber(const string& text, double& value) {
+    char* end;
+    errno = 0;
+    value = strtod(text.c_str(), &end);
+    return !text.empty() && *end == '\0' && errno == 0 && isfinite(value);
+}
+
+bool parseNumber(const string& text, long long& value) {
+    char* end;
+    errno = 0;
+    value = strtoll(text.c_str(), &end, 10);
+    return !text.empty() && *end == '\0' && errno == 0;
+}
+
+/*
+ * Read the options into options. Returns the error message, empty if they are valid.
+ */
+string parseOptions(int argc, char* argv[], Options& options) {
+    for (int id = 1; id < argc; id += 2) {
+        string option = argv[id];
+        if (id + 1 == argc)
+            return "Option " + option + " needs a value";
+        string value = argv[id + 1];
+
+        double real = 0;
+        long long integer = 0;
+        bool ok = true;
+        if (option == "--commands") {
+            ok = parseNumber(value, integer) && integer >= 0;
+            options.commands = integer;
+        } else if (option == "--mix") {
+            options.mix.assign(5, 0);
+            size_t position = 0;
+            int kind = 0;
+            for (; kind < 5 && ok && position <= value.size(); ++kind) {
+                size_t next = value.find(':', position);
+                ok = parseNumber(value.substr(position, next - position), real) && real >= 0;
+                options.mix[kind] = real;
+                position = next == string::npos ? value.size() + 1 : next + 1;
+            }
+            ok = ok && kind >= 3 && position > value.size() &&
+                 options.mix[0] + options.mix[1] + options.mix[2] + options.mix[3] + options.mix[4] > 0;
+        } else if (option == "--prices") {
+            ok = value == "uniform" || value == "zipf" || value == "clustered";
+            options.prices = value;
+        } else if (option == "--max-price") {
+            ok = parseNumber(value, real) && real >= 0 && real <= 1e15;
+            options.maxPrice = real;
+        } else if (option == "--zipf-s") {
+            ok = parseNumber(value, real) && real > 0;
+            options.zipfS = real;
+        } else if (option == "--clusters") {
+            ok = parseNumber(value, integer) && integer >= 1 && integer <= 1000000;
+            options.clusters = (int) integer;
+        } else if (option == "--width") {
+            ok = parseNumber(value, real) && real >= 0 && real <= 1e15;
+            options.width = real;
+        } else if (option == "--names") {
+            ok = parseNumber(value, integer) && integer >= 1 && integer <= INT32_MAX;
+            options.names = (int) integer;
+        } else if (option == "--seed") {
+            ok = parseNumber(value, integer);
+            options.seed = (unsigned long long) integer;
+        } else {
+            return "Unknown option " + option;
+        }
+        if (!ok)
+            return "Invalid value " + value + " of " + option;
+    }
+    return "";
+}
+
+string formatPrice(long long cents) {
+    char text[32];
+    snprintf(text, sizeof(text), "$%lld.%02lld", cents / 100, cents % 100);
+    return text;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    string error = parseOptions(argc, argv, options);
+    if (!error.empty()) {
+        cerr << error << endl << endl << usage;
+        return 1;
+    }
+
+    mt19937_64 random(options.seed);
+    PriceDistribution distribution(options, random);
+    discrete_distribution<int> command(options.mix.begin(), options.mix.end());
+    long long widthCents = (long long) llround(options.width * 100);
+
+    vector<pair<long long, int>> inventory; // items in stock: price in cents, name id
+
+    string output = to_string(options.commands) + "\n";
+    for (long long id = 0; id < options.commands; ++id) {
+        int kind = command(random);
+        if (kind == 1 && inventory.empty())
+            kind = 0; // nothing to remove
+
+        if (kind == 0) {
+            pair<long long, int> item(distribution.next(random), (int) (random() % options.names));
+            inventory.push_back(item);
+            output += "ADD " + formatPrice(item.first) + " Item " + to_string(item.second) + "\n";
+        } else if (kind == 1) {
+            size_t position = random() % inventory.size();
+            pair<long long, int> item = inventory[position];
+            inventory[position] = inventory.back();
+            inventory.pop_back();
+            output += "REMOVE " + formatPrice(item.first) + " Item " + to_string(item.second) + "\n";
+        } else {
+            static const char* queries[] = {"", "", "LIST ", "COUNT ", "SUM "};
+            long long from = distribution.next(random);
+            long long to = from + (long long) (random() % (widthCents + 1));
+            output += queries[kind] + formatPrice(from) + " " + formatPrice(to) + "\n";
+        }
+
+        if (output.size() > (1 << 20)) {
+            fwrite(output.data(), 1, output.size(), stdout);
+            output.clear();
+        }
+    }
+    fwrite(output.data(), 1, output.size(), stdout);
+
+    return 0;
+}
@@ -6,7 +6,26 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <cstring>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <charconv>
 #include <iomanip>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <sstream>
+#include <chrono>
+#include <cstdint>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 using namespace std;
 
@@ -23,6 +42,10 @@ using namespace std;
  * The only thing i'm added to class ArraySortedList is overload of
  * indexOf method, because command LIST accepts two doubles. So, to
  * searchRange i need to access the elements of a pair <double, string>
+ *
+ * main() uses PawnShopInventory, which implements the same Sorted List
+ * of pairs, but keeps prices and names in separate columns (see below)
+ * and stores prices as integer cents (see Price).
  */
 template <typename T>
 class ListADT {
@@ -34,30 +57,92 @@ class ListADT {
 template <typename T>
 class List : ListADT<T> {
 private:
+    typedef allocator_traits<allocator<T>> Traits;
+
+    allocator<T> alloc; // gives raw memory, the elements are constructed only when pushed
     T* arr;
     int arraySize;
     int numberOfElements;
+
+    /*
+     * Time complexity O(N) worst case
+     * Move the elements into raw storage of the new size.
+     * Slots after the elements stay not constructed.
+     */
+    void reallocate(int newSize) {
+        T* tempArr = Traits::allocate(alloc, newSize);
+
+        for (int i = 0; i < numberOfElements; ++i) {
+            Traits::construct(alloc, tempArr + i, std::move(arr[i]));
+            Traits::destroy(alloc, arr + i);
+        }
+
+        if (arr != nullptr)
+            Traits::deallocate(alloc, arr, arraySize);
+        arraySize = newSize;
+        arr = tempArr;
+    }
 public:
     List() {
-        arr = new T[1];
-        arraySize = 1;
+        arr = nullptr;
+        arraySize = 0;
         numberOfElements = 0;
     }
-    // Time complexity O(N) worst case
-    void push(T item) override {
-        if (numberOfElements == arraySize) {
-            T* tempArr = new T[arraySize * 2];
 
-            for (int i = 0; i < numberOfElements; ++i)
-                tempArr[i] = arr[i];
+    List(const List& other) : List() {
+        reserve(other.numberOfElements);
+        for (int i = 0; i < other.numberOfElements; ++i)
+            Traits::construct(alloc, arr + i, other.arr[i]);
+        numberOfElements = other.numberOfElements;
+    }
+
+    List(List&& other) noexcept : List() {
+        std::swap(arr, other.arr);
+        std::swap(arraySize, other.arraySize);
+        std::swap(numberOfElements, other.numberOfElements);
+    }
+
+    // Both copy and move assignment: other is already a copy (or moved) List
+    List& operator=(List other) {
+        std::swap(arr, other.arr);
+        std::swap(arraySize, other.arraySize);
+        std::swap(numberOfElements, other.numberOfElements);
+        return *this;
+    }
+
+    ~List() {
+        for (int i = 0; i < numberOfElements; ++i)
+            Traits::destroy(alloc, arr + i);
+        if (arr != nullptr)
+            Traits::deallocate(alloc, arr, arraySize);
+    }
+
+    // Time complexity O(N) worst case. Make room for capacity elements without reallocations
+    void reserve(int capacity) {
+        if (capacity > arraySize)
+            reallocate(capacity);
+    }
 
-            delete [] arr;
-            arraySize *= 2;
-            arr = tempArr;
+    /*
+     * Time complexity O(N) worst case, O(1) amortized
+     * Construct the new element right in the array from args.
+     * On reallocation the elements are moved, not copied.
+     */
+    template <typename... Args>
+    T& emplace(Args&&... args) {
+        if (numberOfElements == arraySize) {
+            T item(std::forward<Args>(args)...); // args may refer to an element of the List
+            reallocate(arraySize == 0 ? 1 : arraySize * 2);
+            Traits::construct(alloc, arr + numberOfElements, std::move(item));
+        } else {
+            Traits::construct(alloc, arr + numberOfElements, std::forward<Args>(args)...);
         }
+        return arr[numberOfElements++];
+    }
 
-        arr[numberOfElements] = item;
-        numberOfElements++;
+    // Time complexity O(N) worst case, O(1) amortized
+    void push(T item) override {
+        emplace(std::move(item));
     }
 
     // Time complexity O(1) worst case
@@ -65,7 +150,7 @@ public:
         if (index < 0 || index >= numberOfElements) {
             cout << "There are no elements with index = " << index << " in the array." << endl;
             cout << "Returning the first element." << endl;
-            return arr[0];
+            return numberOfElements == 0 ? T() : arr[0];
         }
         return arr[index];
     }
@@ -84,6 +169,8 @@ public:
     virtual T greatest() = 0; // return the greatest element
     virtual T get(int i) = 0; // return the i-th least element
     virtual int indexOf(T item) = 0; // return the index of an element (in a sorted sequence)
+    virtual int lowerBound(const T& item) = 0; // return the index of the first element which is not less than item
+    virtual int upperBound(const T& item) = 0; // return the index of the first element which is greater than item
     virtual void remove(int i) = 0; // remove i-th least element from the Sorted List
     virtual List<T> searchRange(T from, T to) = 0; // find all items between from and to
     virtual List<T> searchRange(pair<double, double>) = 0; // Overloading of searchRange method for pairs
@@ -91,80 +178,221 @@ public:
     virtual bool isEmpty() = 0; // return whether the Sorted List is empty
 };
 
+/*
+ * Lazy view of the elements between two positions of a Sorted List.
+ * Iterators point right into the storage of the Sorted List, so
+ * nothing is copied. The view is valid until the Sorted List is modified.
+ */
+template <typename Iterator>
+class SortedRange {
+private:
+    Iterator first;
+    Iterator last;
+public:
+    SortedRange(Iterator first, Iterator last) : first(first), last(last) {}
+
+    Iterator begin() const {
+        return first;
+    }
+
+    Iterator end() const {
+        return last;
+    }
+
+    bool isEmpty() const {
+        return first == last;
+    }
+};
+
+/*
+ * Sort the array [first, last) using all the cores.
+ *
+ * Time complexity: O(N log N / P + N log P) worst case
+ * P - number of threads.
+ *
+ * The array is split into P chunks which are sorted in parallel,
+ * then neighbouring chunks are merged in parallel, doubling the chunk size
+ * every round. Small arrays are sorted in the current thread, since starting
+ * the threads costs more than sorting them.
+ */
+template <typename T>
+void parallelSort(T* first, T* last) {
+    const long long minParallelSize = 1 << 16;
+    long long n = last - first;
+    long long threads = thread::hardware_concurrency();
+
+    if (n < minParallelSize || threads <= 1) {
+        sort(first, last);
+        return;
+    }
+    if (threads > n / minParallelSize)
+        threads = n / minParallelSize;
+
+    long long chunk = (n + threads - 1) / threads;
+    vector<thread> workers;
+    for (long long begin = 0; begin < n; begin += chunk)
+        workers.emplace_back([=] { sort(first + begin, first + min(n, begin + chunk)); });
+    for (thread& worker : workers)
+        worker.join();
+
+    for (; chunk < n; chunk *= 2) {
+        workers.clear();
+        for (long long begin = 0; begin + chunk < n; begin += 2 * chunk)
+            workers.emplace_back([=] { inplace_merge(first + begin, first + begin + chunk, first + min(n, begin + 2 * chunk)); });
+        for (thread& worker : workers)
+            worker.join();
+    }
+}
+
 template <typename T>
 class ArraySortedList : SortedList <T> {
 private:
+    typedef allocator_traits<allocator<T>> Traits;
+
+    allocator<T> alloc; // gives raw memory, the elements are constructed only when added
     T* array; // dynamic array, where we will store our data
     int arraySize; // size of the array
     int numberOfElements; // actual number of elements in the array
+
+    /*
+     * Time complexity: O(N) worst case
+     * Move the elements into raw storage of the new size.
+     * Slots after the elements stay not constructed.
+     */
+    void reallocate(int newSize) {
+        T* tempArr = Traits::allocate(alloc, newSize);
+
+        for (int id = 0; id < numberOfElements; ++id) {
+            Traits::construct(alloc, tempArr + id, std::move(array[id]));
+            Traits::destroy(alloc, array + id);
+        }
+
+        if (array != nullptr)
+            Traits::deallocate(alloc, array, arraySize);
+        arraySize = newSize;
+        array = tempArr;
+    }
 public:
     // Constructor
     ArraySortedList() {
-        array = new T[1];
-        arraySize = 1;
+        array = nullptr;
+        arraySize = 0;
         numberOfElements = 0;
     }
 
+    ~ArraySortedList() {
+        for (int id = 0; id < numberOfElements; ++id)
+            Traits::destroy(alloc, array + id);
+        if (array != nullptr)
+            Traits::deallocate(alloc, array, arraySize);
+    }
+
+    ArraySortedList(const ArraySortedList&) = delete;
+    ArraySortedList& operator=(const ArraySortedList&) = delete;
+
+    /*
+     * Time complexity: O(N) worst case
+     * Make room for capacity elements, so next adds do not reallocate.
+     */
+    void reserve(int capacity) {
+        if (capacity > arraySize)
+            reallocate(capacity);
+    }
+
+    /*
+     * Constructor from an unsorted batch [first, last), see addAll.
+     */
+    template <typename Iterator>
+    ArraySortedList(Iterator first, Iterator last) : ArraySortedList() {
+        addAll(first, last);
+    }
+
+    /*
+     * Time complexity: O(M log M / P + N + M) worst case
+     * N - actual number of elements in the array.
+     * M - number of elements in the batch.
+     * P - number of threads.
+     *
+     * Adding the elements one by one takes O(N) shifts per element, i.e. O((N + M) * M).
+     * Instead:
+     *   (1) copy the batch and sort it (in parallel for big batches)
+     *   (2) make sure the array can store N + M elements (double strategy)
+     *   (3) merge the array and the batch from the end: the greatest of the two
+     *       tails goes to the last free slot. Every element is moved once, so it is linear.
+     */
+    template <typename Iterator>
+    void addAll(Iterator first, Iterator last) {
+        vector<T> batch(first, last);
+        parallelSort(batch.data(), batch.data() + batch.size());
+
+        int batchSize = (int) batch.size();
+        if (numberOfElements + batchSize > arraySize) {
+            int newSize = arraySize == 0 ? 1 : arraySize;
+            while (newSize < numberOfElements + batchSize)
+                newSize *= 2;
+            reallocate(newSize);
+        }
+
+        // Slots after numberOfElements are not constructed yet
+        int arrayId = numberOfElements - 1;
+        int batchId = batchSize - 1;
+        for (int id = numberOfElements + batchSize - 1; batchId >= 0; --id) {
+            T& source = arrayId >= 0 && batch[batchId] < array[arrayId] ? array[arrayId--] : batch[batchId--];
+            if (id >= numberOfElements)
+                Traits::construct(alloc, array + id, std::move(source));
+            else
+                array[id] = std::move(source);
+        }
+        numberOfElements += batchSize;
+    }
+
     /*
-    * Time complexity: O(N * K) worst case
+    * Time complexity: O(N + log N * K) worst case
     * N - actual number of elements in the array.
     * K - number of iterations for comparing the objects
     *
     * 1) If we won't resize the array:
-    *   We will go through all the elements until we find an element larger than the item,
-    *   then we swap elements from the end, till found this element. All in all, it takes linear
-    *   time.
-    *   Also, if we have type T = string, every comparison will take K iterations in the worst case,
-    *   where K is the length of the strings: O(2K) = O(K).
-    *   In the worst case, if we will compare all strings, i.e.
-    *   go in the loop till the end, time complexity will be O(N * K)
-    *
-    *   Explanation: Assume we have all string with the same length K. Thus, to compare the
-    *   whole string we need to compare each char, which will take K iterations.
-    *   (abcd v abce : a = a, b = b, c = c, but d < e => abcd < abce)
+    *   We find the position of the item with binary search (see lowerBound), it takes
+    *   O(log N * K) for strings of length K. Then we move the elements after the position
+    *   one slot to the right, starting from the end. It takes linear time.
+    *   Elements are moved, not copied, so for T = string only pointers are moved.
     *
-    * 2) If we wll resize the array:
-    *   (1) create new array B with doubled size of A
-    *   (2) store elements of A in B
-    *   (3) delete A
-    *   (4) reassign array B into A
-    *   It will take linear time.
+    * 2) If we will resize the array:
+    *   (1) allocate raw storage B with doubled size of A
+    *   (2) move elements of A into B
+    *   (3) free A
+    *   It will take linear time, but amortized O(1) per add.
     *   After that do the steps of 1) (linear time)
     *   So, the time complexity is O(N + N) = O(N) worst case
+    *
+    * Item is taken by value: pass an rvalue (or use emplace) and it is never copied.
     */
     void add(T item) override {
         // Resize part
-        if (numberOfElements == arraySize) {
-            T* tempArr = new T[arraySize * 2];
-
-            for (int id = 0; id < arraySize; ++id)
-                tempArr[id] = array[id];
-
-            delete [] array;
-            arraySize *= 2;
-            array = tempArr;
-        }
+        if (numberOfElements == arraySize)
+            reallocate(arraySize == 0 ? 1 : arraySize * 2);
 
         // Adding part
-        if (numberOfElements == 0) {
-            array[numberOfElements] = item;
+        int position = lowerBound(item);
+        if (position == numberOfElements) {
+            Traits::construct(alloc, array + numberOfElements, std::move(item));
         } else {
-            bool added = false;
-            for (int id = 0; id < numberOfElements; ++id) {
-                if (item <= array[id]) {
-                    added = true;
-                    for (int p_id = numberOfElements; p_id > id; --p_id)
-                        swap(array[p_id - 1], array[p_id]);
-                    array[id] = item;
-                    break;
-                }
-            }
-            if (!added)
-                array[numberOfElements] = item;
+            Traits::construct(alloc, array + numberOfElements, std::move(array[numberOfElements - 1]));
+            for (int id = numberOfElements - 1; id > position; --id)
+                array[id] = std::move(array[id - 1]);
+            array[position] = std::move(item);
         }
         numberOfElements++;
     }
 
+    /*
+     * Construct the item from args and add it, see add.
+     */
+    template <typename... Args>
+    void emplace(Args&&... args) {
+        add(T(std::forward<Args>(args)...));
+    }
+
     /*
      * Time complexity: O(1) worst case
      * Since we have a Sorted List, the minimum element is
@@ -173,7 +401,7 @@ public:
     T least() override {
         if (numberOfElements == 0) {
             cout << "There are no elements in the array." << endl;
-            return array[numberOfElements];
+            return T();
         } else
             return array[0];
     }
@@ -186,7 +414,7 @@ public:
     T greatest() override {
         if (numberOfElements == 0) {
             cout << "There are no elements in the array." << endl;
-            return array[numberOfElements];
+            return T();
         } else
             return array[numberOfElements - 1];
     }
@@ -196,41 +424,81 @@ public:
      * Since we know the id of the element and accessing the array takes constant time.
      */
     T get(int i) override {
-        if (i < 0 || i > numberOfElements) {
+        if (i <= 0 || i > numberOfElements) {
             cout << "There are no " << i << "th element in the array." << endl;
             cout << "Returning the least element." << endl;
-            return array[0];
+            return least();
         }
         return array[i - 1];
     }
 
     /*
-    * Time complexity: O(N * K) worst case
-    * N - actual number of elements in the array.
-    * K - number of iterations for comparing the objects.
-    *
-    * In the worst case, if item will be equal to the maximum element or it does not exist
-    * we will go through all the elements of the array, which will take linear time O(N).
-    *
-    *
-    * Also, if we have type T = string, every comparison will take K iterations in the worst case,
-    * where K is the length of the strings O(K).
-    *
-    * Explanation: Assume we have all string with the same length K. Thus, to compare the
-    * whole string we need to compare each char, which will take K iterations.
-    * ("abcd" v "abce" : a = a, b = b, c = c, but d < e => abcd < abce)
-    */
-    int indexOf(T item) override {
-        int index = -1;
+     * Time complexity: O(log N * K) worst case
+     * N - actual number of elements in the array.
+     * K - number of iterations for comparing the objects.
+     *
+     * Binary search: the array is sorted, so all elements before the answer are
+     * less than item and all elements after it are not. Each iteration halves
+     * the segment [left, right), so we do log N comparisons.
+     */
+    int lowerBound(const T& item) override {
+        return lowerBound(item, [](const T& element) -> const T& { return element; });
+    }
 
-        for (int id = 0; id < numberOfElements; ++id) {
-            if (array[id] == item) {
-                index = id;
-                break;
-            }
+    /*
+     * Time complexity: O(log N * K) worst case
+     * Same binary search as lowerBound, but skips the elements equal to item.
+     */
+    int upperBound(const T& item) override {
+        return upperBound(item, [](const T& element) -> const T& { return element; });
+    }
+
+    /*
+     * Overloading of lowerBound for a key of the elements.
+     * key(element) should be ordered in the same way as the elements,
+     * e.g. the price of pair <double, string>, so we compare only doubles.
+     */
+    template <typename K, typename Key>
+    int lowerBound(const K& value, Key key) {
+        int left = 0, right = numberOfElements;
+        while (left < right) {
+            int middle = (left + right) / 2;
+            if (key(array[middle]) < value)
+                left = middle + 1;
+            else
+                right = middle;
         }
+        return left;
+    }
+
+    /*
+     * Overloading of upperBound for a key of the elements.
+     */
+    template <typename K, typename Key>
+    int upperBound(const K& value, Key key) {
+        int left = 0, right = numberOfElements;
+        while (left < right) {
+            int middle = (left + right) / 2;
+            if (value < key(array[middle]))
+                right = middle;
+            else
+                left = middle + 1;
+        }
+        return left;
+    }
+
+    /*
+     * Time complexity: O(log N * K) worst case
+     * N - actual number of elements in the array.
+     * K - number of iterations for comparing the objects.
+     *
+     * The first occurrence of item is the lower bound of it,
+     * if the element there is not equal to item, there is no such element.
+     */
+    int indexOf(T item) override {
+        int index = lowerBound(item);
 
-        if (index == -1) {
+        if (index == numberOfElements || !(array[index] == item)) {
             cout << "This object is not in the array." << endl;
             cout << "Returning id of the least element." << endl;
             return 0;
@@ -241,7 +509,7 @@ public:
     /*
      * Time complexity: O(N) worst case
      * In the worst case we need to remove first element of the array.
-     * Due this reason, we need to swap all elements till the end.
+     * Due this reason, we need to move all elements till the end one slot to the left.
      * Thus, it will take linear time.
      */
     void remove(int i) override {
@@ -251,56 +519,73 @@ public:
         }
 
         for (int id = i - 1; id < numberOfElements - 1; ++id)
-            swap(array[id], array[id + 1]);
+            array[id] = std::move(array[id + 1]);
 
+        Traits::destroy(alloc, array + numberOfElements - 1);
         numberOfElements--;
     }
 
     /*
-     * Time complexity: O(N * K) worst case
+     * Time complexity: O(log N * K + M) worst case
      * N - actual number of elements in the array.
      * K - number of iterations for comparing the objects.
+     * M - number of found elements.
      *
-     * In all cases we go throw all elements of array.
-     * In the worst case, we should add into the List all the elements
-     * of array, i.e. execute push() method N times. Worst case of push
-     * is O(N) (double strategy), but array won't double every added element, due
-     * to that amortized cost of push is O(1). So, the time complexity of the
-     * searchRange method is linear.
-     *
-     * Also, if we have type T = string, every comparison will take K iterations in the worst case,
-     * where K is the length of the strings: O(2K) = O(K).
-     *
-     * Explanation: Assume we have all string with the same length K. Thus, to compare the
-     * whole string we need to compare each char, which will take K iterations.
-     * (abcd v abce : a = a, b = b, c = c, but d < e => abcd < abce)
+     * Elements between from and to are exactly the elements with indices
+     * [lowerBound(from), upperBound(to)), both bounds take O(log N * K).
+     * Then we push M elements into the List, amortized cost of push is O(1).
      */
     List<T> searchRange(T from, T to) override {
         List<T> lst;
 
-        for (int id = 0; id < numberOfElements; ++id) {
-            if (from <= array[id] && array[id] <= to) {
-                lst.push(array[id]);
-            }
-        }
+        int last = upperBound(to);
+        for (int id = lowerBound(from); id < last; ++id)
+            lst.push(array[id]);
 
         return lst;
     }
 
     /*
      * Overloading of searchRange method for pairs.
+     * Time complexity: O(log N + M) worst case
+     * Same as searchRange, but the bounds are found by the price only.
      */
     List<T> searchRange(pair<double, double> pr) override {
+        auto price = [](const T& element) { return element.first; };
+
         List<T> lst;
-        for (int id = 0; id < numberOfElements; ++id) {
-            if (pr.first <= array[id].first && array[id].first <= pr.second) {
-                lst.push(array[id]);
-            }
-        }
+        int last = upperBound(pr.second, price);
+        for (int id = lowerBound(pr.first, price); id < last; ++id)
+            lst.push(array[id]);
 
         return lst;
     }
 
+    /*
+     * Time complexity: O(log N * K) worst case
+     * Same bounds as in searchRange, but nothing is copied:
+     * the view is just a pair of pointers into the array.
+     */
+    SortedRange<const T*> range(T from, T to) {
+        const T* first = array + lowerBound(from);
+        if (to < from)
+            return SortedRange<const T*>(first, first);
+        return SortedRange<const T*>(first, array + upperBound(to));
+    }
+
+    /*
+     * Overloading of range method for pairs.
+     * Time complexity: O(log N) worst case
+     */
+    SortedRange<const T*> range(pair<double, double> pr) {
+        auto price = [](const T& element) { return element.first; };
+
+        const T* first = array + lowerBound(pr.first, price);
+        if (pr.second < pr.first)
+            return SortedRange<const T*>(first, first);
+        return SortedRange<const T*>(first, array + upperBound(pr.second, price));
+    }
+
     /*
      * Time complexity: O(1) worst case
      * Just return value of variable. Constant time.
@@ -319,60 +604,1807 @@ public:
 };
 
 /*
- * Function that casts string to double.
+ * Price as a whole number of cents.
+ *
+ * Prices are money with two digits after the dot, so they are stored exactly:
+ * "$123.45" is 12345 cents. Comparison is comparison of 8-byte integers, so
+ * equal prices are really equal (REMOVE finds the item it was given), which
+ * is not guaranteed for doubles.
+ */
+struct Price {
+    long long cents;
+
+    Price() : cents(0) {}
+    explicit Price(long long cents) : cents(cents) {}
+
+    /*
+     * Time complexity: O(1) worst case
+     * Nearest price to a number of dollars.
+     */
+    static Price fromDouble(double dollars) {
+        return Price(llround(dollars * 100));
+    }
+
+    /*
+     * Time complexity: O(L) worst case
+     * L - length of the string.
+     *
+     * Hand-written parser of prices like "$123.45" (the dollar sign is optional).
+     * Digits are collected into the number of cents, digits after the first two
+     * after the dot are rounded half up (they are not expected in the input).
+     */
+    static Price parse(string_view text) {
+        if (!text.empty() && text[0] == '$')
+            text.remove_prefix(1); // Remove the dollar sign
+
+        size_t id = 0;
+        bool negative = id < text.size() && text[id] == '-';
+        if (negative || (id < text.size() && text[id] == '+'))
+            id++;
+
+        long long cents = 0;
+        int fractionDigits = -1; // -1 before the dot
+        bool roundUp = false;
+        for (; id < text.size(); ++id) {
+            char symbol = text[id];
+            if (symbol == '.' && fractionDigits < 0) {
+                fractionDigits = 0;
+            } else if (symbol >= '0' && symbol <= '9') {
+                if (fractionDigits < 2) {
+                    cents = cents * 10 + (symbol - '0');
+                    if (fractionDigits >= 0)
+                        fractionDigits++;
+                } else if (fractionDigits == 2) {
+                    roundUp = symbol >= '5';
+                    fractionDigits++;
+                }
+            } else {
+                break;
+            }
+        }
+
+        for (int digit = max(fractionDigits, 0); digit < 2; ++digit)
+            cents *= 10;
+        cents += roundUp;
+        return Price(negative ? -cents : cents);
+    }
+
+    bool operator==(const Price& other) const { return cents == other.cents; }
+    bool operator!=(const Price& other) const { return cents != other.cents; }
+    bool operator<(const Price& other) const { return cents < other.cents; }
+    bool operator<=(const Price& other) const { return cents <= other.cents; }
+    bool operator>(const Price& other) const { return cents > other.cents; }
+    bool operator>=(const Price& other) const { return cents >= other.cents; }
+};
+
+/*
+ * Output of a price with two digits after the dot, e.g. 123.45 (without the dollar sign).
  */
-double stringToDouble (string price) {
-    price.erase(price.begin()); // Remove the dollar sign
-    return stod(price);
+ostream& operator<<(ostream& out, const Price& price) {
+    long long cents = price.cents;
+    if (cents < 0) {
+        out << '-';
+        cents = -cents;
+    }
+    return out << cents / 100 << '.' << (char) ('0' + cents / 10 % 10) << (char) ('0' + cents % 10);
 }
 
 /*
- * Answer's output function.
+ * Hash index of the inventory: (price, name) -> number of such items.
+ *
+ * Open addressing with linear probing in a power-of-two table. Every entry keeps
+ * its own copy of the name in the character pool of the index, so the entries do
+ * not depend on the arena of the inventory, which is compacted. When the last item
+ * is removed, its entry is deleted with backward shift (the following entries of the
+ * cluster move back into the hole), so there are no tombstones and the table holds
+ * only the items in stock. The table is rebuilt twice bigger when it is half full;
+ * it is rebuilt smaller, with the pool compacted, when most of the pool is names of
+ * deleted entries. So the memory is proportional to the current inventory.
+ *
+ * Lookup and update take O(K) expected time, K - length of the name.
  */
-void printList(List <pair<double, string>> lst) {
-    cout << fixed << setprecision(2); // For output two characters after a dot.
+class ItemIndex {
+private:
+    struct Entry {
+        size_t hash; // 0 - empty slot
+        long long cents;
+        size_t offset; // position of the name in the pool
+        size_t length;
+        int count;
+    };
 
-    int listSize = lst.size();
-    for (int i = 0; i < listSize; ++i) {
-        if (i != 0) {
-            cout << ", $" <<  lst.get(i).first << " " << lst.get(i).second;
-        } else {
-            cout << "$" << lst.get(i).first << " " << lst.get(i).second;
+    vector<Entry> table;
+    vector<char> pool; // names of the entries
+    size_t garbage; // bytes of the pool which belong to the deleted entries
+    int used; // number of not empty slots
+
+    static const size_t minimalSize = 16;
+
+    static size_t hashOf(Price price, string_view name) {
+        size_t hash = std::hash<string_view>()(name) ^ ((size_t) price.cents * 0x9E3779B97F4A7C15ULL);
+        return hash == 0 ? 1 : hash;
+    }
+
+    /*
+     * Slot with the item or the empty slot where it should be inserted.
+     */
+    size_t find(size_t hash, Price price, string_view name) const {
+        size_t mask = table.size() - 1;
+        for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+            const Entry& entry = table[slot];
+            if (entry.hash == 0)
+                return slot;
+            if (entry.hash == hash && entry.cents == price.cents &&
+                string_view(pool.data() + entry.offset, entry.length) == name)
+                return slot;
+        }
+    }
+
+    /*
+     * Time complexity: O(S + L), S - size of the table, L - length of the live names
+     * Move the entries into a table of the given size and their names into a new pool.
+     */
+    void rebuild(size_t size) {
+        vector<Entry> old(size);
+        old.swap(table);
+        vector<char> oldPool;
+        oldPool.reserve(pool.size() - garbage);
+        oldPool.swap(pool);
+        garbage = 0;
+
+        size_t mask = table.size() - 1;
+        for (Entry entry : old) {
+            if (entry.hash == 0)
+                continue;
+            size_t slot = entry.hash & mask;
+            while (table[slot].hash != 0)
+                slot = (slot + 1) & mask;
+            pool.insert(pool.end(), oldPool.begin() + entry.offset, oldPool.begin() + entry.offset + entry.length);
+            entry.offset = pool.size() - entry.length;
+            table[slot] = entry;
         }
     }
-    cout << endl;
-}
 
-int main() {
-    ArraySortedList <pair<double, string>> sortedList;
-    List <pair<double, string>> list;
+    /*
+     * Time complexity: O(C) expected, C - length of the cluster after the slot
+     * Empty the slot and shift back the entries of the cluster which can take it.
+     */
+    void erase(size_t hole) {
+        size_t mask = table.size() - 1;
+        garbage += table[hole].length;
+        for (size_t next = (hole + 1) & mask; table[next].hash != 0; next = (next + 1) & mask) {
+            size_t home = table[next].hash & mask;
+            // the entry may move only if the hole is between its home slot and its slot
+            if (((next - home) & mask) >= ((next - hole) & mask)) {
+                table[hole] = table[next];
+                hole = next;
+            }
+        }
+        table[hole] = Entry();
+        used--;
+    }
 
-    int N;
-    cin >> N;
+public:
+    ItemIndex() : table(minimalSize) {
+        garbage = 0;
+        used = 0;
+    }
 
-    string command;
-    string price, item, price2;
-    while (N--) {
-        cin >> command;
-        if (command == "ADD") {
-            cin >> price;
-            cin.ignore();
-            getline(cin, item);
+    /*
+     * Number of items with the given price and name.
+     */
+    int count(Price price, string_view name) const {
+        const Entry& entry = table[find(hashOf(price, name), price, name)];
+        return entry.hash == 0 ? 0 : entry.count;
+    }
 
-            sortedList.add(make_pair(stringToDouble(price), item));
-        } else if (command == "REMOVE") {
-            cin >> price;
-            cin.ignore();
-            getline(cin, item);
+    void increment(Price price, string_view name) {
+        size_t hash = hashOf(price, name);
+        size_t slot = find(hash, price, name);
+        if (table[slot].hash == 0) {
+            if (2 * (used + 1) > (int) table.size()) {
+                rebuild(table.size() * 2);
+                slot = find(hash, price, name);
+            }
+            Entry& entry = table[slot];
+            entry.hash = hash;
+            entry.cents = price.cents;
+            entry.offset = pool.size();
+            entry.length = name.size();
+            entry.count = 0;
+            pool.insert(pool.end(), name.begin(), name.end());
+            used++;
+        }
+        table[slot].count++;
+    }
 
-            // get index of pair with object price and then delete the pair
-            sortedList.remove(sortedList.indexOf(make_pair(stringToDouble(price), item)) + 1);
-        } else if (command == "LIST") {
-            cin >> price >> price2;
-            list = sortedList.searchRange(make_pair(stringToDouble(price), stringToDouble(price2)));
-            printList(list);
+    void decrement(Price price, string_view name) {
+        size_t slot = find(hashOf(price, name), price, name);
+        if (table[slot].hash == 0 || --table[slot].count > 0)
+            return;
+
+        erase(slot);
+        if (garbage > pool.size() / 2 && garbage > 4096) {
+            size_t size = table.size();
+            while (size > minimalSize && 8 * used < (int) size)
+                size /= 2;
+            rebuild(size);
         }
     }
 
-    return 0;
-}
\ No newline at end of file
+    /*
+     * Time complexity: O(size of the table)
+     * Forget all the items, the memory is kept for the next use.
+     */
+    void clear() {
+        if (used == 0 && garbage == 0)
+            return;
+        fill(table.begin(), table.end(), Entry());
+        pool.clear();
+        garbage = 0;
+        used = 0;
+    }
+};
+
+/*
+ * Number and total value of the items in any price range (COUNT and SUM commands).
+ *
+ * Treap (randomized balanced binary search tree) with a node per distinct price.
+ * Every node keeps how many items have its price and the aggregates of its subtree:
+ * number of items and their total value in cents. The aggregates of a prefix
+ * (all prices below some price) are collected on one path from the root, so a range
+ * is answered in O(log D) expected time, D - number of distinct prices, whatever
+ * the width of the range is. Adding or removing an item changes one path, O(log D) too.
+ */
+class PriceTotals {
+private:
+    struct Node {
+        long long cents;
+        int count; // items with this price
+        unsigned priority; // heap order of the treap
+        int left, right; // children, -1 if there is no child
+        long long subtreeCount;
+        long long subtreeSum; // in cents
+    };
+
+    vector<Node> nodes;
+    vector<int> freeNodes; // slots of the deleted nodes
+    int root;
+    unsigned seed;
+
+    unsigned nextPriority() {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return seed;
+    }
+
+    long long countOf(int node) const {
+        return node < 0 ? 0 : nodes[node].subtreeCount;
+    }
+
+    long long sumOf(int node) const {
+        return node < 0 ? 0 : nodes[node].subtreeSum;
+    }
+
+    void pull(int node) {
+        Node& current = nodes[node];
+        current.subtreeCount = countOf(current.left) + countOf(current.right) + current.count;
+        current.subtreeSum = sumOf(current.left) + sumOf(current.right) + current.cents * current.count;
+    }
+
+    int rotateRight(int node) {
+        int child = nodes[node].left;
+        nodes[node].left = nodes[child].right;
+        nodes[child].right = node;
+        pull(node);
+        pull(child);
+        return child;
+    }
+
+    int rotateLeft(int node) {
+        int child = nodes[node].right;
+        nodes[node].right = nodes[child].left;
+        nodes[child].left = node;
+        pull(node);
+        pull(child);
+        return child;
+    }
+
+    // Join two treaps, all prices of first are less than the prices of second
+    int merge(int first, int second) {
+        if (first < 0 || second < 0)
+            return first < 0 ? second : first;
+        if (nodes[first].priority > nodes[second].priority) {
+            nodes[first].right = merge(nodes[first].right, second);
+            pull(first);
+            return first;
+        }
+        nodes[second].left = merge(first, nodes[second].left);
+        pull(second);
+        return second;
+    }
+
+    int newNode(long long cents) {
+        Node node{cents, 0, nextPriority(), -1, -1, 0, 0};
+        if (!freeNodes.empty()) {
+            int id = freeNodes.back();
+            freeNodes.pop_back();
+            nodes[id] = node;
+            return id;
+        }
+        nodes.push_back(node);
+        return nodes.size() - 1;
+    }
+
+    /*
+     * Add change items with the given price to the subtree, returns its new root.
+     * The node of a price is created with the first item and deleted with the last one.
+     */
+    int update(int node, long long cents, int change) {
+        if (node < 0) {
+            if (change <= 0)
+                return node;
+            node = newNode(cents);
+            nodes[node].count = change;
+            pull(node);
+            return node;
+        }
+
+        if (cents == nodes[node].cents) {
+            nodes[node].count += change;
+            if (nodes[node].count <= 0) {
+                freeNodes.push_back(node);
+                return merge(nodes[node].left, nodes[node].right);
+            }
+        } else if (cents < nodes[node].cents) {
+            int child = update(nodes[node].left, cents, change);
+            nodes[node].left = child;
+            if (child >= 0 && nodes[child].priority > nodes[node].priority)
+                return rotateRight(node);
+        } else {
+            int child = update(nodes[node].right, cents, change);
+            nodes[node].right = child;
+            if (child >= 0 && nodes[child].priority > nodes[node].priority)
+                return rotateLeft(node);
+        }
+        pull(node);
+        return node;
+    }
+
+    /*
+     * Number and total value of the items with price less than (or equal to, if inclusive) price.
+     */
+    pair<long long, long long> prefix(Price price, bool inclusive) const {
+        long long count = 0, sum = 0;
+        for (int node = root; node >= 0; ) {
+            const Node& current = nodes[node];
+            if (current.cents < price.cents || (inclusive && current.cents == price.cents)) {
+                count += countOf(current.left) + current.count;
+                sum += sumOf(current.left) + current.cents * current.count;
+                node = current.right;
+            } else {
+                node = current.left;
+            }
+        }
+        return make_pair(count, sum);
+    }
+
+public:
+    PriceTotals() {
+        root = -1;
+        seed = 2463534242u;
+    }
+
+    void add(Price price) {
+        root = update(root, price.cents, 1);
+    }
+
+    void remove(Price price) {
+        root = update(root, price.cents, -1);
+    }
+
+    void clear() {
+        nodes.clear();
+        freeNodes.clear();
+        root = -1;
+    }
+
+    /*
+     * Time complexity: O(log D) expected
+     * Number of items with prices in [from, to] and their total value in cents.
+     */
+    pair<long long, long long> range(Price from, Price to) const {
+        if (to < from)
+            return make_pair(0LL, 0LL);
+        pair<long long, long long> upper = prefix(to, true);
+        pair<long long, long long> lower = prefix(from, false);
+        return make_pair(upper.first - lower.first, upper.second - lower.second);
+    }
+};
+
+/*
+ * Snapshot of the inventory on disk (see PawnShopInventory::saveSnapshot).
+ *
+ *   SnapshotHeader
+ *   long long prices[count]         - sorted column of prices in cents
+ *   {unsigned offset, length}[count] - names of the items in the string table
+ *   char text[textSize]              - string table, the names one after another
+ *
+ * The columns have the same layout as in memory, so a mapped snapshot is used as it is.
+ * Checksum is FNV-1a of everything after the header.
+ */
+struct SnapshotHeader {
+    char magic[8]; // "PAWNSNAP"
+    uint32_t version;
+    uint32_t count; // number of items
+    uint64_t textSize; // bytes of the string table
+    uint64_t checksum;
+};
+
+uint64_t snapshotChecksum(const char* data, size_t size, uint64_t hash = 14695981039346656037ULL) {
+    for (size_t id = 0; id < size; ++id) {
+        hash ^= (unsigned char) data[id];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/*
+ * Pawn shop inventory: Sorted List of pairs <Price, string> stored as a structure of arrays.
+ *
+ * ArraySortedList <pair<double, string>> keeps 40-byte pairs, so every comparison
+ * of prices pulls a whole string through the cache and every shift moves the strings.
+ * Here the sorted sequence is split into columns:
+ *   prices - contiguous column of prices, binary search and LIST bounds touch only it
+ *   names  - column of references (offset, length) into one character arena
+ * Insert and remove shift only these two compact columns (8 + 8 bytes per item).
+ * Prices are integer cents (see Price), so the price column is a column of 8-byte integers.
+ * Names of the removed items stay in the arena as garbage until it is compacted.
+ *
+ * Items are ordered in the same way as pair <Price, string>: by price, then by name.
+ * ItemIndex counts the items by (price, name), so a missing item is found
+ * without binary search, and count() of any item takes O(1) expected time.
+ */
+class PawnShopInventory : SortedList <pair<Price, string>> {
+public:
+    typedef pair<Price, string> Item;
+    typedef pair<Price, string_view> ItemView; // item as it is stored, name points into the arena
+
+private:
+    struct NameRef {
+        unsigned offset; // position of the name in the arena
+        unsigned length;
+    };
+
+    Price* prices; // sorted column of prices
+    NameRef* names; // names[id] is the name of the item with price prices[id]
+    int capacity; // size of the columns
+    int numberOfElements; // actual number of items
+
+    char* text; // character arena with the names
+    unsigned textSize; // used bytes of the arena
+    unsigned textCapacity; // size of the arena
+    unsigned garbage; // bytes of the arena which belong to the removed items
+
+    ItemIndex itemCounts; // multiplicity of every (price, name), kept in sync by add and remove
+    bool itemCountsBuilt; // false after loadSnapshot, until the index is needed
+    PriceTotals totals; // COUNT and SUM over price ranges, kept in sync by add and remove
+    bool totalsBuilt; // false after loadSnapshot, until COUNT or SUM
+
+    void* mapping; // mapped snapshot (see loadSnapshot), the columns may point into it
+    size_t mappingSize;
+
+    bool isMapped(const void* pointer) const {
+        return mapping != nullptr && pointer >= mapping && pointer < (const char*) mapping + mappingSize;
+    }
+
+    /*
+     * Time complexity: O(N * K) expected when the index is built, O(1) after that
+     * The index of a loaded snapshot is built on the first use, so LIST does not need it.
+     */
+    ItemIndex& counts() {
+        if (!itemCountsBuilt) {
+            itemCounts.clear();
+            for (int id = 0; id < numberOfElements; ++id)
+                itemCounts.increment(prices[id], nameOf(id));
+            itemCountsBuilt = true;
+        }
+        return itemCounts;
+    }
+
+    /*
+     * Time complexity: O(N log D) expected when the tree is built, O(1) after that
+     * The same lazy build as for the index.
+     */
+    PriceTotals& priceTotals() {
+        if (!totalsBuilt) {
+            totals.clear();
+            for (int id = 0; id < numberOfElements; ++id)
+                totals.add(prices[id]);
+            totalsBuilt = true;
+        }
+        return totals;
+    }
+
+    // Keep the index and the totals in sync with a change of the columns, if they are built
+    void updateCount(Price price, string_view name, int change) {
+        if (itemCountsBuilt) {
+            if (change > 0)
+                itemCounts.increment(price, name);
+            else
+                itemCounts.decrement(price, name);
+        }
+        if (totalsBuilt) {
+            if (change > 0)
+                totals.add(price);
+            else
+                totals.remove(price);
+        }
+    }
+
+    // Free the columns and the arena, unless they are in the mapped snapshot
+    void releaseStorage() {
+        if (!isMapped(prices))
+            delete [] prices;
+        if (!isMapped(names))
+            delete [] names;
+        if (!isMapped(text))
+            delete [] text;
+        if (mapping != nullptr)
+            munmap(mapping, mappingSize);
+        mapping = nullptr;
+        mappingSize = 0;
+    }
+
+    string_view nameOf(int id) const {
+        return string_view(text + names[id].offset, names[id].length);
+    }
+
+    /*
+     * Time complexity: O(N) worst case
+     * Double the columns, they are trivially copyable, so it is one memcpy per column.
+     */
+    void growColumns() {
+        int newCapacity = capacity == 0 ? 16 : capacity * 2;
+
+        Price* newPrices = new Price[newCapacity];
+        NameRef* newNames = new NameRef[newCapacity];
+        if (numberOfElements != 0) {
+            memcpy(newPrices, prices, numberOfElements * sizeof(Price));
+            memcpy(newNames, names, numberOfElements * sizeof(NameRef));
+        }
+
+        if (!isMapped(prices))
+            delete [] prices;
+        if (!isMapped(names))
+            delete [] names;
+        prices = newPrices;
+        names = newNames;
+        capacity = newCapacity;
+    }
+
+    /*
+     * Time complexity: O(L) amortized, L - length of the name
+     *
+     * Append the name to the arena and return its offset. If the arena is full,
+     * copy only the live names into a new arena (dropping the garbage), doubling it if needed.
+     * Every byte of garbage is dropped once, so it is amortized O(L).
+     */
+    unsigned storeName(string_view name) {
+        reserveText(name.size());
+
+        unsigned offset = textSize;
+        memcpy(text + textSize, name.data(), name.size());
+        textSize += name.size();
+        return offset;
+    }
+
+    /*
+     * Make room for bytes more characters at the end of the arena (see storeName).
+     * After it the next names of total length bytes are appended without compaction.
+     */
+    void reserveText(size_t bytes) {
+        if (textSize + bytes > textCapacity) {
+            unsigned live = textSize - garbage;
+            unsigned newCapacity = textCapacity == 0 ? 1024 : textCapacity;
+            while (live + bytes > newCapacity / 2)
+                newCapacity *= 2;
+
+            char* newText = new char[newCapacity];
+            unsigned newSize = 0;
+            for (int id = 0; id < numberOfElements; ++id) {
+                memcpy(newText + newSize, text + names[id].offset, names[id].length);
+                names[id].offset = newSize;
+                newSize += names[id].length;
+            }
+
+            if (!isMapped(text))
+                delete [] text;
+            text = newText;
+            textSize = newSize;
+            textCapacity = newCapacity;
+            garbage = 0;
+        }
+    }
+
+    static bool less(const ItemView& left, const ItemView& right) {
+        if (left.first != right.first)
+            return left.first < right.first;
+        return left.second < right.second;
+    }
+
+    // Whether the item with the given id goes before the lower (upper) bound of (price, name)
+    bool before(int id, Price price, string_view name, bool upper) const {
+        if (prices[id] != price)
+            return prices[id] < price;
+        int comparison = nameOf(id).compare(name);
+        return upper ? comparison <= 0 : comparison < 0;
+    }
+
+    /*
+     * Time complexity: O(log N * K) worst case
+     * Binary search on (price, name). Names are compared only inside the run of equal prices.
+     */
+    int bound(Price price, string_view name, bool upper) const {
+        return boundIn(0, numberOfElements, price, name, upper);
+    }
+
+    // The same binary search inside the positions [left, right)
+    int boundIn(int left, int right, Price price, string_view name, bool upper) const {
+        while (left < right) {
+            int middle = (left + right) / 2;
+            if (before(middle, price, name, upper))
+                left = middle + 1;
+            else
+                right = middle;
+        }
+        return left;
+    }
+
+    /*
+     * Time complexity: O(log N) worst case
+     * Binary search on the price column only.
+     */
+    int priceBound(Price price, bool upper) const {
+        int left = 0, right = numberOfElements;
+        while (left < right) {
+            int middle = (left + right) / 2;
+            if (upper ? !(price < prices[middle]) : prices[middle] < price)
+                left = middle + 1;
+            else
+                right = middle;
+        }
+        return left;
+    }
+
+public:
+    /*
+     * Forward iterator over the columns, yields ItemView by value:
+     * the price and a view of the name in the arena, nothing is copied.
+     */
+    class Cursor {
+    private:
+        const PawnShopInventory* inventory;
+        int id;
+    public:
+        Cursor(const PawnShopInventory* inventory, int id) : inventory(inventory), id(id) {}
+
+        ItemView operator*() const {
+            return ItemView(inventory->prices[id], inventory->nameOf(id));
+        }
+
+        Cursor& operator++() {
+            id++;
+            return *this;
+        }
+
+        bool operator==(const Cursor& other) const {
+            return id == other.id;
+        }
+
+        bool operator!=(const Cursor& other) const {
+            return id != other.id;
+        }
+    };
+
+    // Constructor
+    PawnShopInventory() {
+        prices = nullptr;
+        names = nullptr;
+        capacity = 0;
+        numberOfElements = 0;
+        text = nullptr;
+        textSize = textCapacity = garbage = 0;
+        itemCountsBuilt = true;
+        totalsBuilt = true;
+        mapping = nullptr;
+        mappingSize = 0;
+    }
+
+    ~PawnShopInventory() {
+        releaseStorage();
+    }
+
+    PawnShopInventory(const PawnShopInventory&) = delete;
+    PawnShopInventory& operator=(const PawnShopInventory&) = delete;
+
+    /*
+     * Time complexity: O(N + log N * K) worst case
+     * Find the position with binary search, shift the tails of the two columns
+     * with memmove (16 bytes per item), store the name in the arena.
+     */
+    void add(Price price, string_view name) {
+        if (numberOfElements == capacity)
+            growColumns();
+
+        NameRef ref;
+        ref.offset = storeName(name);
+        ref.length = name.size();
+
+        int position = bound(price, name, false);
+        memmove(prices + position + 1, prices + position, (numberOfElements - position) * sizeof(Price));
+        memmove(names + position + 1, names + position, (numberOfElements - position) * sizeof(NameRef));
+        prices[position] = price;
+        names[position] = ref;
+        numberOfElements++;
+        updateCount(price, name, 1);
+    }
+
+    void add(Item item) override {
+        add(item.first, item.second);
+    }
+
+    /*
+     * Time complexity: O(M log M * K + M log N * K + N + L) worst case
+     * M - number of items in the batch, L - total length of their names.
+     *
+     * Add a batch of items at once:
+     *   (1) sort the batch
+     *   (2) make room in the columns and in the arena for all of it
+     *   (3) go from the greatest item of the batch: find its position among the old
+     *       items with binary search, move the old items after it to their final place
+     *       with one memmove and put the item before them.
+     * Every old item is moved once, in blocks.
+     */
+    void addAll(vector<ItemView>& batch) {
+        sort(batch.begin(), batch.end(), less);
+
+        int batchSize = batch.size();
+        while (numberOfElements + batchSize > capacity)
+            growColumns();
+
+        size_t bytes = 0;
+        for (const ItemView& item : batch)
+            bytes += item.second.size();
+        reserveText(bytes);
+
+        int end = numberOfElements; // old items [0, end) are not moved yet
+        for (int batchId = batchSize - 1; batchId >= 0; --batchId) {
+            const ItemView& item = batch[batchId];
+            int position = boundIn(0, end, item.first, item.second, true);
+            memmove(prices + position + batchId + 1, prices + position, (end - position) * sizeof(Price));
+            memmove(names + position + batchId + 1, names + position, (end - position) * sizeof(NameRef));
+
+            prices[position + batchId] = item.first;
+            names[position + batchId].offset = storeName(item.second);
+            names[position + batchId].length = item.second.size();
+            updateCount(item.first, item.second, 1);
+            end = position;
+        }
+        numberOfElements += batchSize;
+    }
+
+    /*
+     * Time complexity: O(M log M * K + M log N * K + N) worst case
+     * M - number of items in the batch, all of them must be in the inventory.
+     *
+     * Remove a batch of items at once: sort the batch, then for every item find its
+     * position among the not moved items with binary search and move the block of kept
+     * items before it to the left with one memmove.
+     */
+    void removeAll(vector<ItemView>& batch) {
+        sort(batch.begin(), batch.end(), less);
+
+        int size = 0; // kept items [0, size) are at their final place
+        int start = 0; // items [start, numberOfElements) are not moved yet
+        for (const ItemView& item : batch) {
+            int position = boundIn(start, numberOfElements, item.first, item.second, false);
+            if (position == numberOfElements || less(item, ItemView(prices[position], nameOf(position))))
+                continue; // not in the inventory
+
+            memmove(prices + size, prices + start, (position - start) * sizeof(Price));
+            memmove(names + size, names + start, (position - start) * sizeof(NameRef));
+            size += position - start;
+
+            updateCount(item.first, item.second, -1);
+            garbage += names[position].length;
+            start = position + 1;
+        }
+        memmove(prices + size, prices + start, (numberOfElements - start) * sizeof(Price));
+        memmove(names + size, names + start, (numberOfElements - start) * sizeof(NameRef));
+        numberOfElements = size + numberOfElements - start;
+    }
+
+    /*
+     * Time complexity: O(1) worst case
+     */
+    Item least() override {
+        if (numberOfElements == 0) {
+            cout << "There are no elements in the array." << endl;
+            return Item();
+        }
+        return get(1);
+    }
+
+    /*
+     * Time complexity: O(1) worst case
+     */
+    Item greatest() override {
+        if (numberOfElements == 0) {
+            cout << "There are no elements in the array." << endl;
+            return Item();
+        }
+        return get(numberOfElements);
+    }
+
+    /*
+     * Time complexity: O(K) worst case
+     * The name is copied out of the arena into the returned pair.
+     */
+    Item get(int i) override {
+        if (i <= 0 || i > numberOfElements) {
+            cout << "There are no " << i << "th element in the array." << endl;
+            cout << "Returning the least element." << endl;
+            return numberOfElements == 0 ? Item() : get(1);
+        }
+        return Item(prices[i - 1], string(nameOf(i - 1)));
+    }
+
+    /*
+     * Time complexity: O(K) expected
+     * Number of items with the given price and name, see ItemIndex.
+     */
+    int count(Price price, string_view name) {
+        return counts().count(price, name);
+    }
+
+    /*
+     * Time complexity: O(log D) expected
+     * Number of items with prices in [from, to] and their total value in cents, see PriceTotals.
+     */
+    pair<long long, long long> totalsInRange(Price from, Price to) {
+        return priceTotals().range(from, to);
+    }
+
+    /*
+     * Time complexity: O(K) expected for a missing item, O(log N * K) worst case otherwise
+     * A missing item is detected by the hash index. Otherwise the first
+     * occurrence of (price, name) is its lower bound.
+     */
+    int indexOf(Price price, string_view name) {
+        if (counts().count(price, name) == 0) {
+            cout << "This object is not in the array." << endl;
+            cout << "Returning id of the least element." << endl;
+            return 0;
+        }
+        return bound(price, name, false);
+    }
+
+    int indexOf(Item item) override {
+        return indexOf(item.first, item.second);
+    }
+
+    int lowerBound(const Item& item) override {
+        return bound(item.first, item.second, false);
+    }
+
+    int upperBound(const Item& item) override {
+        return bound(item.first, item.second, true);
+    }
+
+    /*
+     * Time complexity: O(N) worst case
+     * Shift the tails of the two columns to the left, the name becomes garbage of the arena.
+     */
+    void remove(int i) override {
+        if (i <= 0 || i > numberOfElements) {
+            cout << "There are no " << i << "th element in the array." << endl;
+            return;
+        }
+
+        updateCount(prices[i - 1], nameOf(i - 1), -1);
+        garbage += names[i - 1].length;
+        memmove(prices + i - 1, prices + i, (numberOfElements - i) * sizeof(Price));
+        memmove(names + i - 1, names + i, (numberOfElements - i) * sizeof(NameRef));
+        numberOfElements--;
+    }
+
+    /*
+     * Time complexity: O(log N * K + M) worst case
+     * M - number of found items, they are copied into the List.
+     */
+    List<Item> searchRange(Item from, Item to) override {
+        List<Item> lst;
+
+        int last = upperBound(to);
+        for (int id = lowerBound(from); id < last; ++id)
+            lst.emplace(prices[id], string(nameOf(id)));
+
+        return lst;
+    }
+
+    /*
+     * Overloading of searchRange method for pairs.
+     * Time complexity: O(log N + M) worst case
+     */
+    List<Item> searchRange(pair<double, double> pr) override {
+        List<Item> lst;
+
+        int last = priceBound(Price::fromDouble(pr.second), true);
+        for (int id = priceBound(Price::fromDouble(pr.first), false); id < last; ++id)
+            lst.emplace(prices[id], string(nameOf(id)));
+
+        return lst;
+    }
+
+    /*
+     * Time complexity: O(log N) worst case
+     * Bounds are found on the price column only, nothing is copied.
+     */
+    SortedRange<Cursor> range(pair<Price, Price> pr) {
+        int first = priceBound(pr.first, false);
+        int last = pr.second < pr.first ? first : priceBound(pr.second, true);
+        return SortedRange<Cursor>(Cursor(this, first), Cursor(this, last));
+    }
+
+    /*
+     * Time complexity: O(N + L) worst case
+     * L - total length of the names.
+     *
+     * Write the snapshot (see SnapshotHeader). The string table is written compacted:
+     * the names go in the order of the items, without the garbage of the arena.
+     * The snapshot is written to <path>.tmp and renamed over path when it is on disk,
+     * so the old file is never truncated: it may be the mapped snapshot of this
+     * inventory, and a crash in the middle leaves it whole.
+     * Returns false if the file can not be written.
+     */
+    bool saveSnapshot(const char* path) const {
+        SnapshotHeader header{};
+        memcpy(header.magic, "PAWNSNAP", 8);
+        header.version = 1;
+        header.count = numberOfElements;
+        header.textSize = 0;
+
+        vector<NameRef> compacted(numberOfElements);
+        for (int id = 0; id < numberOfElements; ++id) {
+            compacted[id].offset = header.textSize;
+            compacted[id].length = names[id].length;
+            header.textSize += names[id].length;
+        }
+
+        uint64_t checksum = snapshotChecksum((const char*) prices, numberOfElements * sizeof(Price));
+        checksum = snapshotChecksum((const char*) compacted.data(), numberOfElements * sizeof(NameRef), checksum);
+        for (int id = 0; id < numberOfElements; ++id)
+            checksum = snapshotChecksum(text + names[id].offset, names[id].length, checksum);
+        header.checksum = checksum;
+
+        string temporary = string(path) + ".tmp";
+        FILE* file = fopen(temporary.c_str(), "wb");
+        if (file == nullptr)
+            return false;
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+        ok = ok && fwrite(prices, sizeof(Price), numberOfElements, file) == (size_t) numberOfElements;
+        ok = ok && fwrite(compacted.data(), sizeof(NameRef), numberOfElements, file) == (size_t) numberOfElements;
+        for (int id = 0; id < numberOfElements && ok; ++id)
+            ok = fwrite(text + names[id].offset, 1, names[id].length, file) == names[id].length;
+        ok = ok && fflush(file) == 0 && fsync(fileno(file)) == 0;
+        ok = fclose(file) == 0 && ok;
+        ok = ok && rename(temporary.c_str(), path) == 0;
+        if (!ok)
+            std::remove(temporary.c_str());
+        return ok;
+    }
+
+    /*
+     * Time complexity: O(S) worst case, S - size of the file (only the checksum is computed)
+     *
+     * Replace the inventory with the snapshot. The file is mapped privately
+     * (copy on write) and the columns point right into the mapping, so nothing
+     * is parsed, copied or sorted. Changes after loading go to the copied pages,
+     * the file is not modified. When a column has to grow, it moves to the heap.
+     * Returns false (the inventory is not changed) if the file is not a valid snapshot.
+     * Besides the checksum, the structure is checked: every name is inside the string
+     * table and the prices are sorted, so a forged file can not make the columns lie.
+     */
+    bool loadSnapshot(const char* path) {
+        int descriptor = open(path, O_RDONLY);
+        if (descriptor < 0)
+            return false;
+
+        struct stat status;
+        void* data = MAP_FAILED;
+        size_t size = 0;
+        if (fstat(descriptor, &status) == 0 && (size_t) status.st_size >= sizeof(SnapshotHeader)) {
+            size = status.st_size;
+            data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0);
+        }
+        close(descriptor);
+        if (data == MAP_FAILED)
+            return false;
+
+        const SnapshotHeader* header = (const SnapshotHeader*) data;
+        size_t columns = (size_t) header->count * (sizeof(Price) + sizeof(NameRef));
+        const char* payload = (const char*) data + sizeof(SnapshotHeader);
+        bool valid = memcmp(header->magic, "PAWNSNAP", 8) == 0 && header->version == 1 &&
+                     size - sizeof(SnapshotHeader) >= columns &&
+                     size - sizeof(SnapshotHeader) - columns == header->textSize &&
+                     header->count <= INT_MAX && header->textSize <= UINT_MAX &&
+                     snapshotChecksum(payload, size - sizeof(SnapshotHeader)) == header->checksum;
+        if (valid) {
+            const Price* loadedPrices = (const Price*) payload;
+            const NameRef* loadedNames = (const NameRef*) (payload + header->count * sizeof(Price));
+            for (uint32_t id = 0; id < header->count && valid; ++id) {
+                valid = (uint64_t) loadedNames[id].offset + loadedNames[id].length <= header->textSize &&
+                        (id == 0 || !(loadedPrices[id] < loadedPrices[id - 1]));
+            }
+        }
+        if (!valid) {
+            munmap(data, size);
+            return false;
+        }
+
+        releaseStorage();
+        mapping = data;
+        mappingSize = size;
+
+        numberOfElements = capacity = header->count;
+        prices = (Price*) payload;
+        names = (NameRef*) (payload + header->count * sizeof(Price));
+        text = (char*) payload + columns;
+        textSize = textCapacity = header->textSize;
+        garbage = 0;
+        itemCountsBuilt = false;
+        totalsBuilt = false;
+        return true;
+    }
+
+    /*
+     * Time complexity: O(1) worst case
+     */
+    int size() override {
+        return numberOfElements;
+    }
+
+    /*
+     * Time complexity: O(1) worst case
+     */
+    bool isEmpty() override {
+        return numberOfElements == 0;
+    }
+};
+
+/*
+ * Batched execution of the commands (main --batch).
+ *
+ * ADD and REMOVE are not applied at once, but kept until the next LIST (or the end
+ * of the input). A REMOVE of a kept ADD of the same item cancels it. Before LIST the
+ * rest is applied with one pass of removeAll and one merge of addAll, so a run of M
+ * changes costs O(N + M log M) instead of O(N * M).
+ *
+ * The result is the same as of the sequential execution: the order of changes between
+ * two LISTs does not matter, as long as every REMOVE finds its item. A REMOVE of a
+ * missing item (which prints a message and removes the least item) applies the kept
+ * changes and then runs sequentially.
+ */
+class CommandBatch {
+private:
+    struct PendingItem {
+        Price price;
+        size_t offset; // position of the name in text
+        size_t length;
+    };
+
+    PawnShopInventory& inventory;
+    vector<PendingItem> adds, removes;
+    vector<char> text; // names of the kept items, the commands give only views
+    ItemIndex addCounts; // kept ADDs not cancelled yet
+    ItemIndex removeCounts; // kept REMOVEs
+    vector<PawnShopInventory::ItemView> views; // reused for the batches
+
+    PendingItem keep(Price price, string_view name) {
+        PendingItem item{price, text.size(), name.size()};
+        text.insert(text.end(), name.begin(), name.end());
+        return item;
+    }
+
+    string_view nameOf(const PendingItem& item) const {
+        return string_view(text.data() + item.offset, item.length);
+    }
+
+public:
+    explicit CommandBatch(PawnShopInventory& inventory) : inventory(inventory) {}
+
+    /*
+     * Time complexity: O(K) expected
+     */
+    void add(Price price, string_view name) {
+        adds.push_back(keep(price, name));
+        addCounts.increment(price, name);
+    }
+
+    /*
+     * Time complexity: O(K) expected, if the item exists
+     */
+    void remove(Price price, string_view name) {
+        if (addCounts.count(price, name) > 0) {
+            addCounts.decrement(price, name); // cancel a kept ADD
+            return;
+        }
+        if (inventory.count(price, name) > removeCounts.count(price, name)) {
+            removes.push_back(keep(price, name));
+            removeCounts.increment(price, name);
+            return;
+        }
+
+        // Missing item: the same as the sequential REMOVE
+        apply();
+        inventory.remove(inventory.indexOf(price, name) + 1);
+    }
+
+    /*
+     * Time complexity: O(N + M log M * K) worst case
+     * Apply all the kept changes to the inventory.
+     */
+    void apply() {
+        if (!removes.empty()) {
+            views.clear();
+            for (const PendingItem& item : removes)
+                views.emplace_back(item.price, nameOf(item));
+            inventory.removeAll(views);
+        }
+
+        if (!adds.empty()) {
+            views.clear();
+            for (const PendingItem& item : adds) {
+                string_view name = nameOf(item);
+                if (addCounts.count(item.price, name) > 0) { // not cancelled
+                    addCounts.decrement(item.price, name);
+                    views.emplace_back(item.price, name);
+                }
+            }
+            inventory.addAll(views);
+        }
+
+        adds.clear();
+        removes.clear();
+        text.clear();
+        addCounts.clear();
+        removeCounts.clear();
+    }
+};
+
+/*
+ * Buffered reader of the command stream.
+ *
+ * Input is read with fread in big chunks into one buffer, tokens are returned as
+ * string_views into it, so reading a command does not allocate. A view is valid
+ * until the next call: to return a token, which crosses the end of the chunk,
+ * its beginning is moved to the front of the buffer before reading the next chunk.
+ * The buffer grows only if a single token (line) is longer than it.
+ *
+ * Tokens are split in the same way as cin >> does, and restOfLine works as
+ * cin.ignore() + getline, so the parsed commands are the same as before.
+ */
+class CommandReader {
+private:
+    FILE* input;
+    vector<char> buffer;
+    size_t position; // first not consumed byte
+    size_t end; // end of the read bytes
+
+    static bool isSpace(char symbol) {
+        return symbol == ' ' || symbol == '\n' || symbol == '\t' || symbol == '\r' || symbol == '\v' || symbol == '\f';
+    }
+
+    /*
+     * Time complexity: O(L) worst case
+     * L - length of the kept part [from, end).
+     * Move [from, end) to the front and read the next chunk after it.
+     * Returns false if there is no more input.
+     */
+    bool refill(size_t& from) {
+        size_t kept = end - from;
+        memmove(buffer.data(), buffer.data() + from, kept);
+        position -= from;
+        from = 0;
+        end = kept;
+        if (end == buffer.size())
+            buffer.resize(buffer.size() * 2);
+
+        size_t read = fread(buffer.data() + end, 1, buffer.size() - end, input);
+        end += read;
+        return read != 0;
+    }
+
+public:
+    explicit CommandReader(FILE* input, size_t chunkSize = 1 << 16) : input(input), buffer(chunkSize) {
+        position = 0;
+        end = 0;
+    }
+
+    /*
+     * Time complexity: O(L) worst case
+     * L - length of the token and the spaces before it.
+     * Empty view means the end of the input.
+     */
+    string_view token() {
+        while (true) {
+            while (position < end && isSpace(buffer[position]))
+                position++;
+            size_t nothingToKeep = position;
+            if (position < end || !refill(nothingToKeep))
+                break;
+        }
+        size_t start = position;
+        while (true) {
+            while (position < end && !isSpace(buffer[position]))
+                position++;
+            if (position < end || !refill(start))
+                break;
+        }
+        return string_view(buffer.data() + start, position - start);
+    }
+
+    /*
+     * Time complexity: O(L) worst case
+     * Skip one character (the space after the previous token) and return the rest of the line.
+     */
+    string_view restOfLine() {
+        size_t start = position;
+        if (position == end)
+            refill(start);
+        if (position < end)
+            position++;
+
+        start = position;
+        while (true) {
+            while (position < end && buffer[position] != '\n')
+                position++;
+            if (position < end || !refill(start))
+                break;
+        }
+        string_view line(buffer.data() + start, position - start);
+        if (position < end)
+            position++; // the line break
+        return line;
+    }
+};
+
+/* ==== Shared code (OutputWriter) ====
+ * Byte-identical copy of the one in 2.3_AccountingForACafe.cpp: each program is submitted as one file. */
+
+/*
+ * Buffered writer of the answers.
+ *
+ * A response is formatted into one reusable buffer by hand-written formatters
+ * (no iostream formatting) and given to the output with a single fwrite by flush().
+ * The buffer grows to the size of the largest response and is reused after that,
+ * so formatting does not allocate.
+ */
+class OutputWriter {
+private:
+    FILE* output;
+    vector<char> buffer;
+    size_t used; // bytes of the current response
+
+    char* reserve(size_t bytes) {
+        if (used + bytes > buffer.size())
+            buffer.resize(max(buffer.size() * 2, used + bytes));
+        return buffer.data() + used;
+    }
+
+public:
+    explicit OutputWriter(FILE* output, size_t capacity = 1 << 16) : output(output), buffer(capacity) {
+        used = 0;
+    }
+
+    ~OutputWriter() {
+        flush();
+    }
+
+    OutputWriter(const OutputWriter&) = delete;
+    OutputWriter& operator=(const OutputWriter&) = delete;
+
+    void write(char symbol) {
+        *reserve(1) = symbol;
+        used++;
+    }
+
+    void write(string_view text) {
+        memcpy(reserve(text.size()), text.data(), text.size());
+        used += text.size();
+    }
+
+    /*
+     * Time complexity: O(number of digits)
+     * Digits are produced from the end into a small buffer on the stack.
+     */
+    void writeInteger(long long value) {
+        char digits[24];
+        int length = 0;
+        unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long) value : value;
+        do {
+            digits[sizeof(digits) - 1 - length++] = (char) ('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude != 0);
+        if (value < 0)
+            digits[sizeof(digits) - 1 - length++] = '-';
+        write(string_view(digits + sizeof(digits) - length, length));
+    }
+
+    /*
+     * Time complexity: O(number of digits)
+     * Amount of money given in cents with two digits after the dot, e.g. 12345 -> 123.45
+     */
+    void writeCents(long long cents) {
+        if (cents < 0) {
+            write('-');
+            cents = -cents;
+        }
+        writeInteger(cents / 100);
+        char* fraction = reserve(3);
+        fraction[0] = '.';
+        fraction[1] = (char) ('0' + cents / 10 % 10);
+        fraction[2] = (char) ('0' + cents % 10);
+        used += 3;
+    }
+
+    /*
+     * Pass the response to the output with one call.
+     */
+    void flush() {
+        if (used != 0)
+            fwrite(buffer.data(), 1, used, output);
+        used = 0;
+    }
+};
+
+/* ==== End of shared code (OutputWriter) ==== */
+
+/*
+ * Answer's output function.
+ * Elements are read by reference right from the range, without copying,
+ * and the whole line is written with one call.
+ */
+template <typename Range>
+void printList(OutputWriter& out, const Range& range) {
+    bool isFirst = true;
+    for (const auto& element : range) {
+        if (!isFirst)
+            out.write(", ");
+        out.write('$');
+        out.writeCents(element.first.cents);
+        out.write(' ');
+        out.write(element.second);
+        isFirst = false;
+    }
+    out.write('\n');
+    out.flush();
+}
+
+/*
+ * Histogram of command latencies (main --latency).
+ *
+ * Log-linear buckets: values are split by the highest bit into groups of powers of two,
+ * every group is split into 16 equal buckets. So a percentile is found with at most
+ * 1/16 (6%) relative error, with a fixed small array for any range of values.
+ */
+class LatencyHistogram {
+private:
+    static const int subBuckets = 16;
+    long long buckets[64 * subBuckets] = {};
+    long long total = 0;
+    long long maximum = 0;
+
+    // Values below 32 have own buckets, greater values v go to group shift, where v >> shift is in [16, 32)
+    static int bucketOf(long long value) {
+        if (value < 2 * subBuckets)
+            return (int) value;
+        int shift = 63 - __builtin_clzll(value) - 4;
+        return (shift + 1) * subBuckets + (int) (value >> shift) - subBuckets;
+    }
+
+    // The greatest value of the bucket
+    static long long upperOf(int bucket) {
+        if (bucket < 2 * subBuckets)
+            return bucket;
+        int shift = bucket / subBuckets - 1;
+        return ((long long) (bucket % subBuckets + subBuckets + 1) << shift) - 1;
+    }
+
+public:
+    void record(long long nanoseconds) {
+        buckets[bucketOf(max(nanoseconds, 0LL))]++;
+        total++;
+        maximum = max(maximum, nanoseconds);
+    }
+
+    long long count() const {
+        return total;
+    }
+
+    /*
+     * Time complexity: O(number of buckets)
+     * Smallest value v (up to the bucket precision) such that the share q of the values is not greater than v.
+     */
+    long long percentile(double q) const {
+        long long rank = (long long) ceil(q * total), seen = 0;
+        for (int bucket = 0; bucket < 64 * subBuckets; ++bucket) {
+            seen += buckets[bucket];
+            if (seen >= rank && seen > 0)
+                return min(upperOf(bucket), maximum);
+        }
+        return maximum;
+    }
+};
+
+/*
+ * Bounded ring buffer between one producer thread and one consumer thread.
+ *
+ * Slots are allocated once and reused: the producer fills the slot returned by
+ * startPush and publishes it with finishPush, the consumer reads the slot returned
+ * by startPop and gives it back with finishPop. Only the producer moves tail and
+ * only the consumer moves head, so no locks are needed. A full (empty) ring makes
+ * the producer (consumer) yield until the other side moves.
+ */
+template <typename T>
+class SpscRing {
+private:
+    vector<T> slots;
+    size_t mask;
+    alignas(64) atomic<size_t> head; // next slot to read
+    alignas(64) atomic<size_t> tail; // next slot to write
+
+public:
+    // capacity must be a power of two
+    explicit SpscRing(size_t capacity) : slots(capacity), mask(capacity - 1), head(0), tail(0) {}
+
+    T& startPush() {
+        size_t position = tail.load(memory_order_relaxed);
+        while (position - head.load(memory_order_acquire) == slots.size())
+            this_thread::yield();
+        return slots[position & mask];
+    }
+
+    void finishPush() {
+        tail.store(tail.load(memory_order_relaxed) + 1, memory_order_release);
+    }
+
+    T& startPop() {
+        size_t position = head.load(memory_order_relaxed);
+        while (position == tail.load(memory_order_acquire))
+            this_thread::yield();
+        return slots[position & mask];
+    }
+
+    void finishPop() {
+        head.store(head.load(memory_order_relaxed) + 1, memory_order_release);
+    }
+};
+
+/*
+ * Parsed command, passed from the parser to the apply stage of the pipeline.
+ * The name is copied out of the input buffer, the string of the slot keeps its capacity.
+ */
+struct PipelineCommand {
+    enum Type { ADD, REMOVE, LIST, COUNT, SUM, CHECKPOINT, END } type;
+    Price first, second;
+    string text; // name of the item or path of the checkpoint
+};
+
+/*
+ * Result of a command, passed from the apply stage to the formatter.
+ * LIST items are copied out of the inventory (it changes after the command),
+ * but they are formatted by the formatter thread.
+ */
+struct PipelineResponse {
+    enum Type { LIST, COUNT, SUM, TEXT, END } type;
+    vector<Price> prices;
+    vector<unsigned> lengths; // lengths of the names
+    string names; // names one after another, or the text of a TEXT response
+    long long value;
+};
+
+/*
+ * Parser stage: read the commands and pass them on, END after the last one.
+ */
+void parseCommands(CommandReader& reader, int N, SpscRing<PipelineCommand>& commands) {
+    while (N--) {
+        string_view command = reader.token();
+        PipelineCommand::Type type;
+        if (command == "ADD")
+            type = PipelineCommand::ADD;
+        else if (command == "REMOVE")
+            type = PipelineCommand::REMOVE;
+        else if (command == "LIST")
+            type = PipelineCommand::LIST;
+        else if (command == "COUNT")
+            type = PipelineCommand::COUNT;
+        else if (command == "SUM")
+            type = PipelineCommand::SUM;
+        else if (command == "CHECKPOINT")
+            type = PipelineCommand::CHECKPOINT;
+        else if (command.empty())
+            break;
+        else
+            continue;
+
+        PipelineCommand& slot = commands.startPush();
+        slot.type = type;
+        if (type == PipelineCommand::ADD || type == PipelineCommand::REMOVE) {
+            slot.first = Price::parse(reader.token());
+            slot.text.assign(reader.restOfLine());
+        } else if (type == PipelineCommand::CHECKPOINT) {
+            slot.text.assign(reader.token());
+        } else {
+            slot.first = Price::parse(reader.token());
+            slot.second = Price::parse(reader.token());
+        }
+        commands.finishPush();
+    }
+
+    commands.startPush().type = PipelineCommand::END;
+    commands.finishPush();
+}
+
+/*
+ * Apply stage: the only thread which touches the inventory.
+ * Messages, which the inventory prints to cout, are collected in messages
+ * (cout is redirected there) and passed on as TEXT responses, so they keep their place.
+ */
+void applyCommands(PawnShopInventory& inventory, CommandBatch& batch, bool batched, stringstream& messages,
+                   SpscRing<PipelineCommand>& commands, SpscRing<PipelineResponse>& responses) {
+    while (true) {
+        PipelineCommand& command = commands.startPop();
+        PipelineCommand::Type type = command.type;
+
+        if (type == PipelineCommand::ADD) {
+            if (batched)
+                batch.add(command.first, command.text);
+            else
+                inventory.add(command.first, command.text);
+        } else if (type == PipelineCommand::REMOVE) {
+            if (batched)
+                batch.remove(command.first, command.text);
+            else
+                inventory.remove(inventory.indexOf(command.first, command.text) + 1);
+        } else if (type == PipelineCommand::CHECKPOINT) {
+            batch.apply();
+            if (!inventory.saveSnapshot(command.text.c_str()))
+                cerr << "Can not save the snapshot " << command.text << endl;
+        } else if (type != PipelineCommand::END) {
+            batch.apply();
+        }
+
+        if (messages.tellp() > 0) {
+            PipelineResponse& response = responses.startPush();
+            response.type = PipelineResponse::TEXT;
+            response.names = messages.str();
+            messages.str("");
+            responses.finishPush();
+        }
+
+        if (type == PipelineCommand::LIST) {
+            PipelineResponse& response = responses.startPush();
+            response.type = PipelineResponse::LIST;
+            response.prices.clear();
+            response.lengths.clear();
+            response.names.clear();
+            for (const auto& element : inventory.range(make_pair(command.first, command.second))) {
+                response.prices.push_back(element.first);
+                response.lengths.push_back(element.second.size());
+                response.names.append(element.second);
+            }
+            responses.finishPush();
+        } else if (type == PipelineCommand::COUNT || type == PipelineCommand::SUM) {
+            pair<long long, long long> totals = inventory.totalsInRange(command.first, command.second);
+            PipelineResponse& response = responses.startPush();
+            response.type = type == PipelineCommand::COUNT ? PipelineResponse::COUNT : PipelineResponse::SUM;
+            response.value = type == PipelineCommand::COUNT ? totals.first : totals.second;
+            responses.finishPush();
+        }
+        commands.finishPop();
+
+        if (type == PipelineCommand::END)
+            break;
+    }
+    batch.apply();
+
+    responses.startPush().type = PipelineResponse::END;
+    responses.finishPush();
+}
+
+/*
+ * Formatter stage: write the responses in the order they come.
+ */
+void formatResponses(OutputWriter& out, SpscRing<PipelineResponse>& responses) {
+    while (true) {
+        PipelineResponse& response = responses.startPop();
+        if (response.type == PipelineResponse::END) {
+            responses.finishPop();
+            break;
+        }
+
+        if (response.type == PipelineResponse::TEXT) {
+            out.write(response.names);
+        } else if (response.type == PipelineResponse::LIST) {
+            size_t offset = 0;
+            for (size_t id = 0; id < response.prices.size(); ++id) {
+                if (id != 0)
+                    out.write(", ");
+                out.write('$');
+                out.writeCents(response.prices[id].cents);
+                out.write(' ');
+                out.write(string_view(response.names.data() + offset, response.lengths[id]));
+                offset += response.lengths[id];
+            }
+            out.write('\n');
+        } else {
+            if (response.type == PipelineResponse::SUM) {
+                out.write('$');
+                out.writeCents(response.value);
+            } else {
+                out.writeInteger(response.value);
+            }
+            out.write('\n');
+        }
+        out.flush();
+        responses.finishPop();
+    }
+}
+
+/*
+ * Time complexity: the same as of the sequential loop, but the three stages run in parallel.
+ *
+ * Three-stage pipeline (main --pipeline): parser thread -> apply thread -> formatter
+ * (this thread), connected by bounded SPSC rings. Reading and parsing of the next
+ * commands and formatting of the previous answers overlap with changes of the inventory.
+ * Every stage handles the commands in order, so the output is the same as in sequential mode.
+ */
+void runPipeline(CommandReader& reader, int N, PawnShopInventory& inventory, CommandBatch& batch, bool batched,
+                 OutputWriter& out) {
+    SpscRing<PipelineCommand> commands(1024);
+    SpscRing<PipelineResponse> responses(64);
+
+    stringstream messages;
+    streambuf* console = cout.rdbuf(messages.rdbuf());
+
+    thread parser(parseCommands, ref(reader), N, ref(commands));
+    thread applier(applyCommands, ref(inventory), ref(batch), batched, ref(messages), ref(commands), ref(responses));
+    formatResponses(out, responses);
+
+    parser.join();
+    applier.join();
+    cout.rdbuf(console);
+}
+
+int main(int argc, char* argv[]) {
+    PawnShopInventory sortedList;
+    CommandReader reader(stdin);
+    OutputWriter out(stdout);
+
+    // --batch: keep ADD and REMOVE until the next LIST, see CommandBatch
+    // --snapshot <file>: start from the inventory saved by CHECKPOINT <file>
+    // --pipeline: parse, apply and format in three threads, see runPipeline
+    // --latency: report throughput and latency percentiles of every command to stderr
+    bool batched = false, pipelined = false, measured = false;
+    for (int id = 1; id < argc; ++id) {
+        if (string_view(argv[id]) == "--batch") {
+            batched = true;
+        } else if (string_view(argv[id]) == "--pipeline") {
+            pipelined = true;
+        } else if (string_view(argv[id]) == "--latency") {
+            measured = true;
+        } else if (string_view(argv[id]) == "--snapshot" && id + 1 < argc) {
+            if (!sortedList.loadSnapshot(argv[++id])) {
+                cerr << "Can not load the snapshot " << argv[id] << endl;
+                return 1;
+            }
+        }
+    }
+    if (pipelined && measured) {
+        // commands of the pipeline overlap in three threads, there is no latency of one command
+        cerr << "--latency can not be used with --pipeline" << endl;
+        return 1;
+    }
+    CommandBatch batch(sortedList);
+
+    string_view count = reader.token();
+    int N = 0;
+    from_chars(count.data(), count.data() + count.size(), N);
+
+    if (pipelined) {
+        runPipeline(reader, N, sortedList, batch, batched, out);
+        return 0;
+    }
+
+    const char* kinds[] = {"ADD", "REMOVE", "LIST", "COUNT", "SUM", "CHECKPOINT"};
+    LatencyHistogram latencies[6];
+    auto start = chrono::steady_clock::now();
+
+    while (N--) {
+        auto commandStart = measured ? chrono::steady_clock::now() : start;
+        string_view command = reader.token();
+        int kind = find(kinds, kinds + 6, command) - kinds;
+
+        if (command == "ADD") {
+            Price price = Price::parse(reader.token());
+            if (batched)
+                batch.add(price, reader.restOfLine());
+            else
+                sortedList.add(price, reader.restOfLine());
+        } else if (command == "REMOVE") {
+            Price price = Price::parse(reader.token());
+            string_view item = reader.restOfLine();
+
+            // get index of pair with object price and then delete the pair
+            if (batched)
+                batch.remove(price, item);
+            else
+                sortedList.remove(sortedList.indexOf(price, item) + 1);
+        } else if (command == "LIST") {
+            Price from = Price::parse(reader.token());
+            Price to = Price::parse(reader.token());
+            batch.apply();
+            printList(out, sortedList.range(make_pair(from, to)));
+        } else if (command == "COUNT" || command == "SUM") {
+            bool isCount = command == "COUNT"; // the view is not valid after the next token
+            Price from = Price::parse(reader.token());
+            Price to = Price::parse(reader.token());
+            batch.apply();
+            pair<long long, long long> totals = sortedList.totalsInRange(from, to);
+            if (isCount) {
+                out.writeInteger(totals.first);
+            } else {
+                out.write('$');
+                out.writeCents(totals.second);
+            }
+            out.write('\n');
+            out.flush();
+        } else if (command == "CHECKPOINT") {
+            string path(reader.token());
+            batch.apply();
+            if (!sortedList.saveSnapshot(path.c_str()))
+                cerr << "Can not save the snapshot " << path << endl;
+        } else if (command.empty()) {
+            break;
+        }
+
+        if (measured && kind < 6)
+            latencies[kind].record(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - commandStart).count());
+    }
+    batch.apply();
+
+    if (measured) {
+        out.flush();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        long long commands = 0;
+        for (const LatencyHistogram& histogram : latencies)
+            commands += histogram.count();
+
+        cerr << fixed << setprecision(0);
+        cerr << commands << " commands in " << setprecision(3) << seconds << " s, "
+             << setprecision(0) << commands / seconds << " commands/s" << endl;
+        cerr << "command       count     p50 ns     p99 ns    p999 ns" << endl;
+        for (int id = 0; id < 6; ++id) {
+            if (latencies[id].count() == 0)
+                continue;
+            cerr << left << setw(10) << kinds[id] << right << setw(10) << latencies[id].count()
+                 << setw(11) << latencies[id].percentile(0.5) << setw(11) << latencies[id].percentile(0.99)
+                 << setw(11) << latencies[id].percentile(0.999) << endl;
+        }
+    }
+
+    return 0;
+}
@@ -7,6 +7,17 @@
 #include <iostream>
 #include <string>
 #include <iomanip>
+#include <memory>
+#include <new>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <string_view>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
 
 using namespace std;
 
@@ -14,9 +25,9 @@ using namespace std;
 /*
  * Solution Description:
  *
- * I have a hash map of Lists, since i handle collision by Separate Chaining.
- * Each element of list is a pair of pair and a Set, i.e.
- * each element has following form: pair < pair<string, double> , Set<T> >,
+ * I have a hash map with open addressing (Robin Hood hashing), see HashTable.
+ * Each entry of the table is a key, a value and a Set, i.e.
+ * each entry has following form: < string, double, Set<T> >,
  * call it tuple.
  *
  * When we input a line in the form: date + time + receipt_ID + cost + item_title
@@ -30,10 +41,266 @@ using namespace std;
  * 2) Use method add for sum up all prices, to get total cost
  * I have added a description to each method, so it will not be difficult to understand points 1 and 2
  *
+ * With --approximate [p] the Set of every tuple is replaced with a HyperLogLog sketch
+ * of 2^p bytes, the number of receipts is then an estimate, the memory does not depend on it.
+ *
  * At the end, it only remains to display all tuples in the required form.
  */
 
-const int szP = 50000; // the maximum number of entries in the input
+/* ==== Shared code (allocation resources) ====
+ * Byte-identical copy of the one in 2.1_SortedListADT.cpp: each program is submitted as one file. */
+
+/*
+ * Counters of an allocation resource.
+ */
+struct AllocationStats {
+    long long bytesInUse = 0; // bytes given to the containers and not deallocated yet
+    long long peakBytesInUse = 0; // maximum of bytesInUse
+    long long allocationCalls = 0; // number of allocate calls
+    long long systemAllocations = 0; // number of blocks requested from operator new
+
+    void onAllocate(size_t bytes) {
+        bytesInUse += bytes;
+        allocationCalls++;
+        if (bytesInUse > peakBytesInUse)
+            peakBytesInUse = bytesInUse;
+    }
+
+    void onDeallocate(size_t bytes) {
+        bytesInUse -= bytes;
+    }
+};
+
+/*
+ * Bump (arena) allocation resource.
+ *
+ * Memory is cut from big blocks just by moving a pointer. Deallocate does not
+ * give the memory back, it only updates the counters. The whole arena is reused
+ * at once with reset(), which rewinds to the first block in O(1): the blocks are
+ * kept for the next batch and returned to the system only in the destructor.
+ */
+class Arena {
+private:
+    struct Block {
+        Block* next;
+        size_t size; // number of bytes after the header
+    };
+
+    Block* first; // the chain of all blocks
+    Block* current; // block we cut from
+    char* position; // first free byte of the current block
+    char* end; // end of the current block
+    size_t blockSize; // size of a new block (bigger requests get a block of their own size)
+    AllocationStats stats;
+
+    static char* data(Block* block) {
+        return (char*) (block + 1);
+    }
+
+    void use(Block* block) {
+        current = block;
+        position = data(block);
+        end = position + block->size;
+    }
+
+public:
+    explicit Arena(size_t blockSize = 1 << 16) : first(nullptr), current(nullptr), position(nullptr), end(nullptr), blockSize(blockSize) {}
+
+    ~Arena() {
+        while (first != nullptr) {
+            Block* next = first->next;
+            ::operator delete(first);
+            first = next;
+        }
+    }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /*
+     * Time complexity: O(1) amortized
+     * Align the position, take the next block if the current one is over.
+     */
+    void* allocate(size_t bytes, size_t alignment) {
+        stats.onAllocate(bytes);
+
+        char* aligned = (char*) (((size_t) position + alignment - 1) & ~(alignment - 1));
+        while (current == nullptr || aligned + bytes > end) {
+            if (current != nullptr && current->next != nullptr && current->next->size >= bytes + alignment) {
+                use(current->next); // block left from the previous batch
+            } else {
+                size_t size = max(blockSize, bytes + alignment);
+                Block* block = (Block*) ::operator new(sizeof(Block) + size);
+                block->size = size;
+                stats.systemAllocations++;
+
+                if (current == nullptr) {
+                    block->next = first;
+                    first = block;
+                } else {
+                    block->next = current->next;
+                    current->next = block;
+                }
+                use(block);
+            }
+            aligned = (char*) (((size_t) position + alignment - 1) & ~(alignment - 1));
+        }
+
+        position = aligned + bytes;
+        return aligned;
+    }
+
+    // Time complexity: O(1). Memory is reused only after reset
+    void deallocate(void*, size_t bytes, size_t) {
+        stats.onDeallocate(bytes);
+    }
+
+    /*
+     * Time complexity: O(1)
+     * Forget everything allocated from the arena. Containers which use it
+     * must be destroyed (or never touched again) before that.
+     */
+    void reset() {
+        if (first != nullptr)
+            use(first);
+        stats.bytesInUse = 0;
+    }
+
+    const AllocationStats& statistics() const {
+        return stats;
+    }
+};
+
+/*
+ * Size-class pool allocation resource.
+ *
+ * Requests up to maxPooledSize bytes are rounded up to a power of two (size class).
+ * Every size class keeps a free list of the returned chunks, so a chunk is reused
+ * by the next request of the same class. New chunks are cut from slabs of an Arena.
+ * Bigger requests and requests aligned stronger than a size class go straight to the
+ * aligned operator new, and deallocate returns them to the aligned operator delete.
+ */
+class Pool {
+private:
+    static const int minClassSize = 16;
+    static const int numberOfClasses = 9; // 16, 32, ..., 4096 bytes
+    static const size_t maxPooledSize = minClassSize << (numberOfClasses - 1);
+
+    struct FreeChunk {
+        FreeChunk* next;
+    };
+
+    FreeChunk* freeLists[numberOfClasses];
+    Arena slabs;
+    AllocationStats stats;
+
+    // Whether the chunk comes from a size class (otherwise from operator new)
+    static bool isPooled(size_t bytes, size_t alignment) {
+        return bytes <= maxPooledSize && alignment <= minClassSize;
+    }
+
+    static int sizeClass(size_t bytes) {
+        int sizeClass = 0;
+        while ((size_t) (minClassSize << sizeClass) < bytes)
+            sizeClass++;
+        return sizeClass;
+    }
+
+public:
+    Pool() : slabs(1 << 16) {
+        for (int id = 0; id < numberOfClasses; ++id)
+            freeLists[id] = nullptr;
+    }
+
+    Pool(const Pool&) = delete;
+    Pool& operator=(const Pool&) = delete;
+
+    // Time complexity: O(1) amortized
+    void* allocate(size_t bytes, size_t alignment) {
+        stats.onAllocate(bytes);
+        if (!isPooled(bytes, alignment)) {
+            stats.systemAllocations++;
+            return ::operator new(bytes, align_val_t(alignment));
+        }
+
+        int id = sizeClass(bytes);
+        if (freeLists[id] != nullptr) {
+            FreeChunk* chunk = freeLists[id];
+            freeLists[id] = chunk->next;
+            return chunk;
+        }
+
+        size_t before = slabs.statistics().systemAllocations;
+        void* chunk = slabs.allocate(minClassSize << id, minClassSize);
+        stats.systemAllocations += slabs.statistics().systemAllocations - before;
+        return chunk;
+    }
+
+    // Time complexity: O(1). The chunk goes to the free list of its size class
+    void deallocate(void* pointer, size_t bytes, size_t alignment) {
+        stats.onDeallocate(bytes);
+        if (!isPooled(bytes, alignment)) {
+            ::operator delete(pointer, align_val_t(alignment));
+            return;
+        }
+
+        FreeChunk* chunk = (FreeChunk*) pointer;
+        int id = sizeClass(bytes);
+        chunk->next = freeLists[id];
+        freeLists[id] = chunk;
+    }
+
+    const AllocationStats& statistics() const {
+        return stats;
+    }
+};
+
+/*
+ * Allocator which takes memory from a resource (Arena or Pool).
+ * Copies of the allocator share the resource, so all the containers
+ * created with it (and their rebound allocators) use the same memory.
+ */
+template <typename T, typename Resource>
+class ResourceAllocator {
+public:
+    typedef T value_type;
+    typedef true_type propagate_on_container_copy_assignment;
+    typedef true_type propagate_on_container_move_assignment;
+    typedef true_type propagate_on_container_swap;
+
+    Resource* resource;
+
+    explicit ResourceAllocator(Resource* resource) : resource(resource) {}
+
+    template <typename U>
+    ResourceAllocator(const ResourceAllocator<U, Resource>& other) : resource(other.resource) {}
+
+    T* allocate(size_t n) {
+        return (T*) resource->allocate(n * sizeof(T), alignof(T));
+    }
+
+    void deallocate(T* pointer, size_t n) {
+        resource->deallocate(pointer, n * sizeof(T), alignof(T));
+    }
+
+    template <typename U>
+    bool operator==(const ResourceAllocator<U, Resource>& other) const {
+        return resource == other.resource;
+    }
+
+    template <typename U>
+    bool operator!=(const ResourceAllocator<U, Resource>& other) const {
+        return resource != other.resource;
+    }
+};
+
+template <typename T>
+using ArenaAllocator = ResourceAllocator<T, Arena>;
+
+template <typename T>
+using PoolAllocator = ResourceAllocator<T, Pool>;
+
+/* ==== End of shared code (allocation resources) ==== */
 
 //Set is an associative container that contains a set of unique objects of type T
 template <typename T>
@@ -42,64 +309,145 @@ class SetADT {
     virtual int size() = 0; // return actual number of elements of the set
 };
 
-template <typename T>
+/*
+ * Hash set: open addressing with linear probing.
+ *
+ * Every slot keeps the hash of its object, so an insert compares the objects
+ * (strings) only when the hashes are equal, and growing does not hash again.
+ * The number of slots is a power of two, it doubles when the set is 3/4 full,
+ * so insert takes O(K) expected time (K - length of the object) and counting
+ * the unique objects of N inserts is linear. An empty set does not allocate.
+ */
+template <typename T, typename Alloc = allocator<T>>
 class Set : SetADT<T> {
 private:
-    T* arrayList; // dynamic array which stores unique objects of type T
-    int arraySize; // size of the array
+    struct Slot {
+        size_t hash; // 0 - empty slot, hashes of the objects are never 0 (see hashOf)
+        alignas(T) unsigned char storage[sizeof(T)]; // the object, constructed only in a used slot
+
+        T& item() {
+            return *reinterpret_cast<T*>(storage);
+        }
+    };
+
+    typedef typename allocator_traits<Alloc>::template rebind_alloc<Slot> SlotAlloc;
+    typedef allocator_traits<SlotAlloc> SlotTraits;
+    typedef allocator_traits<Alloc> Traits;
+
+    Alloc alloc; // the objects are constructed with it
+    SlotAlloc slotAlloc; // gives raw memory for the slots
+    Slot* slots; // hash table of the objects
+    int capacity; // number of slots, 0 or a power of two
     int numberOfElements; // actual number of elements
+
+    static size_t hashOf(const T& item) {
+        size_t hashed = hash<T>()(item);
+        return hashed == 0 ? 1 : hashed;
+    }
+
+    // Put an object, which is not in the set, into the first free slot after its home slot
+    void place(T&& item, size_t hashed) {
+        size_t mask = capacity - 1;
+        size_t index = hashed & mask;
+        while (slots[index].hash != 0)
+            index = (index + 1) & mask;
+        Traits::construct(alloc, &slots[index].item(), std::move(item));
+        slots[index].hash = hashed;
+    }
+
+    /*
+     * Time complexity: O(N) worst case
+     * Move the objects into a table of the new size, the cached hashes are reused.
+     */
+    void reallocate(int newCapacity) {
+        Slot* oldSlots = slots;
+        int oldCapacity = capacity;
+
+        slots = SlotTraits::allocate(slotAlloc, newCapacity);
+        for (int i = 0; i < newCapacity; ++i)
+            slots[i].hash = 0;
+        capacity = newCapacity;
+
+        for (int i = 0; i < oldCapacity; ++i) {
+            if (oldSlots[i].hash != 0) {
+                place(std::move(oldSlots[i].item()), oldSlots[i].hash);
+                Traits::destroy(alloc, &oldSlots[i].item());
+            }
+        }
+        if (oldSlots != nullptr)
+            SlotTraits::deallocate(slotAlloc, oldSlots, oldCapacity);
+    }
 public:
     // constructor
-    Set() {
-        arrayList = new T[1];
-        arraySize = 1;
+    explicit Set(const Alloc& alloc = Alloc()) : alloc(alloc), slotAlloc(alloc) {
+        slots = nullptr;
+        capacity = 0;
         numberOfElements = 0;
     }
 
+    Set(const Set& other) : Set(Traits::select_on_container_copy_construction(other.alloc)) {
+        if (other.numberOfElements == 0)
+            return;
+        reallocate(other.capacity);
+        for (int i = 0; i < other.capacity; ++i) {
+            if (other.slots[i].hash != 0) {
+                Traits::construct(alloc, &slots[i].item(), other.slots[i].item());
+                slots[i].hash = other.slots[i].hash;
+            }
+        }
+        numberOfElements = other.numberOfElements;
+    }
+
+    Set(Set&& other) noexcept : Set(other.alloc) {
+        std::swap(slots, other.slots);
+        std::swap(capacity, other.capacity);
+        std::swap(numberOfElements, other.numberOfElements);
+    }
+
+    // Both copy and move assignment: other is already a copy (or moved) Set
+    Set& operator=(Set other) {
+        std::swap(alloc, other.alloc);
+        std::swap(slotAlloc, other.slotAlloc);
+        std::swap(slots, other.slots);
+        std::swap(capacity, other.capacity);
+        std::swap(numberOfElements, other.numberOfElements);
+        return *this;
+    }
+
+    ~Set() {
+        for (int i = 0; i < capacity; ++i) {
+            if (slots[i].hash != 0)
+                Traits::destroy(alloc, &slots[i].item());
+        }
+        if (slots != nullptr)
+            SlotTraits::deallocate(slotAlloc, slots, capacity);
+    }
+
     /*
-     * Time complexity: O(N * K) worst case
-     * N - actual number of elements in the array.
-     * K - number of iterations for comparing the objects
-     *
-     * Actual number of elements equal to the size of the set,
-     * then we apply double strategy, which increase the size
-     * of the array.
-     *
-     * When we insert the object into the set,
-     * we go throw all existing objects O(N), and if
-     * the number is not unique, then we do
-     * nothing.
-     *
-     * Since we compare each iteration, in the worst case
-     * it will take O(K), where K - number of iterations for
-     * comparing the objects.
+     * Time complexity: O(K) expected, amortized over the growth
+     * K - number of iterations for comparing (and hashing) the objects
      *
-     * All in all, method insert takes O(N*K)
+     * Probe the slots from the home slot of the object until a free one.
+     * If a slot with the same hash and an equal object is met, the object
+     * is not unique and we do nothing. Otherwise the object takes the free slot.
+     * When the set becomes 3/4 full, the number of slots is doubled.
      */
     void insert(T item) override {
-        if (numberOfElements == arraySize) {
-            T* tempArr = new T[arraySize * 2];
+        size_t hashed = hashOf(item);
 
-            for (int i = 0; i < numberOfElements; ++i)
-                tempArr[i] = arrayList[i];
-
-            delete [] arrayList;
-            arraySize *= 2;
-            arrayList = tempArr;
-        }
-
-        bool ifInSet = false; // boolean variable, which indicates if the element unique
-        for (int i = 0; i < numberOfElements; ++i) {
-            if (arrayList[i] == item) {
-                ifInSet = true;
-                break;
+        if (capacity != 0) {
+            size_t mask = capacity - 1;
+            for (size_t index = hashed & mask; slots[index].hash != 0; index = (index + 1) & mask) {
+                if (slots[index].hash == hashed && slots[index].item() == item)
+                    return;
             }
         }
 
-        if (!ifInSet) {
-            arrayList[numberOfElements] = item;
-            numberOfElements++;
-        }
+        if ((numberOfElements + 1) * 4 > capacity * 3)
+            reallocate(capacity == 0 ? 4 : capacity * 2);
+
+        place(std::move(item), hashed);
+        numberOfElements++;
     }
 
     /*
@@ -111,117 +459,222 @@ public:
     }
 };
 
-template <typename T>
-class ListADT {
-    virtual void push(T item) = 0; // add a new item to the List
-    virtual T get(int index) = 0; // return the i-th element
-    virtual void add(int ind, double term) = 0; // add object term to the total price
-    virtual void insertInSet(int ind, string ID) = 0; // insert i-th element into the string
-    virtual int getSetSizeFromList(int ind) = 0; // return size of the list
-    virtual int size() = 0; // return the size of the List
-};
-
-template <typename T>
-class List : ListADT<T> {
+/*
+ * Approximate set: HyperLogLog sketch of the distinct objects (main --approximate).
+ *
+ * Only the number of distinct objects can be asked, the objects are not stored.
+ * The 64-bit hash of an object is split into the register index (the first p bits)
+ * and the rest, the register keeps the maximum position of the first 1 bit of the
+ * rest. The registers take 2^p bytes whatever the number of objects is, and the
+ * relative error of size() is about 1.04 / sqrt(2^p) (1.6% for p = 12, 4 KB).
+ *
+ * Sketches with the same precision are merged with max of the registers,
+ * which gives the sketch of the union of the two sets.
+ */
+template <typename T, typename Alloc = allocator<T>>
+class HyperLogLog : SetADT<T> {
 private:
-    T* arrayList; // dynamic array which stores objects of type T
-    int arraySize; // size of the array
-    int numberOfElements; // actual number of elements in the array
-public:
-    // constructor
-    List() {
-        arrayList = new T[1];
-        arraySize = 1;
-        numberOfElements = 0;
+    typedef typename allocator_traits<Alloc>::template rebind_alloc<unsigned char> ByteAlloc;
+    typedef allocator_traits<ByteAlloc> Traits;
+
+    ByteAlloc alloc;
+    unsigned char* registers; // allocated with the first insert
+    int precision; // p, there are 2^p registers
+
+    int registerCount() const {
+        return 1 << precision;
     }
 
-    /*
-     * Time complexity: O(N) worst case
-     *
-     * As in task 2.1, doubling takes linear time.
-     * Due to that, O(N) in the worst case.
-     */
-    void push(T item) override {
-        if (numberOfElements == arraySize) {
-            T* tempArr = new T[arraySize * 2];
+    void allocateRegisters() {
+        registers = Traits::allocate(alloc, registerCount());
+        memset(registers, 0, registerCount());
+    }
+
+    // Hash with all 64 bits mixed (the finalizer of splitmix64)
+    static unsigned long long hashOf(const T& item) {
+        unsigned long long hashed = hash<T>()(item);
+        hashed = (hashed ^ (hashed >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        hashed = (hashed ^ (hashed >> 27)) * 0x94d049bb133111ebULL;
+        return hashed ^ (hashed >> 31);
+    }
+public:
+    static constexpr int minPrecision = 4;
+    static constexpr int maxPrecision = 18;
 
-            for (int i = 0; i < numberOfElements; ++i)
-                tempArr[i] = arrayList[i];
+    explicit HyperLogLog(const Alloc& alloc = Alloc(), int precision = 12) : alloc(alloc) {
+        registers = nullptr;
+        // compared by value: min/max would take the constants by reference (odr-use before C++17)
+        this->precision = precision < minPrecision ? minPrecision : precision > maxPrecision ? maxPrecision : precision;
+    }
 
-            delete [] arrayList;
-            arraySize *= 2;
-            arrayList = tempArr;
+    HyperLogLog(const HyperLogLog& other) : HyperLogLog(other.alloc, other.precision) {
+        if (other.registers != nullptr) {
+            allocateRegisters();
+            memcpy(registers, other.registers, registerCount());
         }
+    }
 
-        arrayList[numberOfElements] = item;
-        numberOfElements++;
+    HyperLogLog(HyperLogLog&& other) noexcept : HyperLogLog(other.alloc, other.precision) {
+        std::swap(registers, other.registers);
+    }
+
+    // Both copy and move assignment: other is already a copy (or moved) sketch
+    HyperLogLog& operator=(HyperLogLog other) {
+        std::swap(alloc, other.alloc);
+        std::swap(registers, other.registers);
+        std::swap(precision, other.precision);
+        return *this;
+    }
+
+    ~HyperLogLog() {
+        if (registers != nullptr)
+            Traits::deallocate(alloc, registers, registerCount());
     }
 
     /*
-     * Time complexity: O(1) worst case
-     *
-     * Just return element from array.
+     * Time complexity: O(K) worst case
+     * K - number of iterations for hashing the object.
      */
-    T get(int index) override {
-        if (index < 0 || index >= numberOfElements) {
-            cout << "There are no elements with index = " << index << " in the array." << endl;
-            cout << "Returning the first element." << endl;
-            return arrayList[0];
-        }
-        return arrayList[index];
+    void insert(T item) override {
+        if (registers == nullptr)
+            allocateRegisters();
+
+        unsigned long long hashed = hashOf(item);
+        int index = hashed >> (64 - precision);
+        unsigned long long rest = (hashed << precision) | (1ULL << (precision - 1)); // the guard bit bounds the rank
+        unsigned char rank = __builtin_clzll(rest) + 1;
+        if (rank > registers[index])
+            registers[index] = rank;
     }
 
     /*
-     * Time complexity: O(1) worst case
-     *
-     * Summation of two doubles takes constant time.
+     * Time complexity: O(2^p) worst case
+     * Union with a sketch of the same precision.
      */
-    void add(int ind, double term) override {
-        if (0 < ind || ind >= numberOfElements) {
-            cout << "Index = " << ind << " is out of range" << endl;
+    void merge(const HyperLogLog& other) {
+        if (other.registers == nullptr || other.precision != precision)
             return;
-        }
-        arrayList[ind].first.second += term;
+        if (registers == nullptr)
+            allocateRegisters();
+        for (int i = 0; i < registerCount(); ++i)
+            registers[i] = max(registers[i], other.registers[i]);
     }
 
     /*
-     * Time complexity: O(N * K) worst case
-     * N - actual number of elements in the array.
-     * K - number of iterations for comparing the objects
-     *
-     * *watch insert method in the class Set
+     * Time complexity: O(2^p) worst case
+     * Estimate of the number of distinct objects: the harmonic mean of 2^register,
+     * with linear counting of the empty registers for small sets (then it is almost exact).
      */
-    void insertInSet(int ind, string ID) override {
-        if (0 < ind || ind >= numberOfElements) {
-            cout << "Index = " << ind << " is out of range" << endl;
-            return;
+    int size() override {
+        if (registers == nullptr)
+            return 0;
+
+        double m = registerCount();
+        double sum = 0;
+        int zeros = 0;
+        for (int i = 0; i < registerCount(); ++i) {
+            sum += ldexp(1.0, -registers[i]);
+            zeros += registers[i] == 0;
         }
-        arrayList[ind].second.insert(ID);
+
+        double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+        if (estimate <= 2.5 * m && zeros != 0)
+            estimate = m * log(m / zeros);
+        return (int) llround(estimate);
+    }
+};
+
+/* ==== Shared code (OutputWriter) ====
+ * Byte-identical copy of the one in 2.2_ManagingPawnShopItems.cpp: each program is submitted as one file. */
+
+/*
+ * Buffered writer of the answers.
+ *
+ * A response is formatted into one reusable buffer by hand-written formatters
+ * (no iostream formatting) and given to the output with a single fwrite by flush().
+ * The buffer grows to the size of the largest response and is reused after that,
+ * so formatting does not allocate.
+ */
+class OutputWriter {
+private:
+    FILE* output;
+    vector<char> buffer;
+    size_t used; // bytes of the current response
+
+    char* reserve(size_t bytes) {
+        if (used + bytes > buffer.size())
+            buffer.resize(max(buffer.size() * 2, used + bytes));
+        return buffer.data() + used;
+    }
+
+public:
+    explicit OutputWriter(FILE* output, size_t capacity = 1 << 16) : output(output), buffer(capacity) {
+        used = 0;
+    }
+
+    ~OutputWriter() {
+        flush();
+    }
+
+    OutputWriter(const OutputWriter&) = delete;
+    OutputWriter& operator=(const OutputWriter&) = delete;
+
+    void write(char symbol) {
+        *reserve(1) = symbol;
+        used++;
+    }
+
+    void write(string_view text) {
+        memcpy(reserve(text.size()), text.data(), text.size());
+        used += text.size();
     }
 
     /*
-     * Time complexity: O(1) worst case
-     *
-     *  *watch size method in the class Set
+     * Time complexity: O(number of digits)
+     * Digits are produced from the end into a small buffer on the stack.
      */
-    int getSetSizeFromList(int ind) override {
-        if (0 < ind || ind >= numberOfElements) {
-            cout << "Index = " << ind << " is out of range" << endl;
-            return 0;
+    void writeInteger(long long value) {
+        char digits[24];
+        int length = 0;
+        unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long) value : value;
+        do {
+            digits[sizeof(digits) - 1 - length++] = (char) ('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude != 0);
+        if (value < 0)
+            digits[sizeof(digits) - 1 - length++] = '-';
+        write(string_view(digits + sizeof(digits) - length, length));
+    }
+
+    /*
+     * Time complexity: O(number of digits)
+     * Amount of money given in cents with two digits after the dot, e.g. 12345 -> 123.45
+     */
+    void writeCents(long long cents) {
+        if (cents < 0) {
+            write('-');
+            cents = -cents;
         }
-        return arrayList[ind].second.size();
+        writeInteger(cents / 100);
+        char* fraction = reserve(3);
+        fraction[0] = '.';
+        fraction[1] = (char) ('0' + cents / 10 % 10);
+        fraction[2] = (char) ('0' + cents % 10);
+        used += 3;
     }
 
     /*
-     * Time complexity: O(1) worst case
-     *
-     * Requires constant time to return the variable.
+     * Pass the response to the output with one call.
      */
-    int size() override {
-        return numberOfElements;
+    void flush() {
+        if (used != 0)
+            fwrite(buffer.data(), 1, used, output);
+        used = 0;
     }
 };
 
+/* ==== End of shared code (OutputWriter) ==== */
+
 template <typename T1, typename T2>
 class MapADT {
     virtual void put (T1 key, T2 value, string ID) = 0; // add a new tuple to the HashMap
@@ -229,65 +682,203 @@ class MapADT {
     virtual int getHashID (T1 item) = 0; // hashing and compressing the object
 };
 
-template <typename T1, typename T2>
+/*
+ * Hash map with open addressing and Robin Hood hashing.
+ *
+ * Tuples are stored right in the slots of one array, there are no chains.
+ * A key is put into the first free slot after its home slot (hash & mask), but
+ * on the way it takes the slot of any tuple which is closer to its own home
+ * ("takes from the rich"), and that tuple continues the search. So the probe
+ * lengths stay short and even, and a search stops as soon as it meets a tuple
+ * closer to its home than the key would be.
+ *
+ * The table starts small and doubles when it is 7/8 full, so
+ * put and getValue take O(1) expected time for any number of keys.
+ */
+template <typename T1, typename T2, typename Alloc = allocator<char>, template <typename, typename> class Distinct = Set>
 class HashTable : MapADT<T1, T2> {
+public:
+    // All the containers of the table take memory from (a copy of) the same allocator
+    typedef typename allocator_traits<Alloc>::template rebind_alloc<string> StringAlloc;
+    typedef Distinct<string, StringAlloc> Receipts; // Set of the receipt IDs, or its sketch
+
+    // An entry of the table, findOrInsert and lookup give it to be updated in place
+    struct Tuple {
+        T1 key;
+        T2 value;
+        Receipts receipts;
+    };
+
 private:
-    /*
-     * An array of Lists, since i handle collision using Separate Chaining
-     */
-    List<pair<pair<T1, T2>, Set<string>>> * table; // We have an array of Lists, since
+
+    struct Slot {
+        unsigned distance; // 0 - empty slot, otherwise 1 + distance from the home slot
+        size_t hash; // cached hash of the key
+        alignas(Tuple) unsigned char storage[sizeof(Tuple)]; // the tuple, constructed only in a used slot
+
+        Tuple& tuple() {
+            return *reinterpret_cast<Tuple*>(storage);
+        }
+    };
+
+    typedef typename allocator_traits<Alloc>::template rebind_alloc<Slot> SlotAlloc;
+    typedef allocator_traits<SlotAlloc> Traits;
+    typedef typename allocator_traits<Alloc>::template rebind_alloc<Tuple> TupleAlloc;
+    typedef allocator_traits<TupleAlloc> TupleTraits;
+
+    SlotAlloc alloc;
+    TupleAlloc tupleAlloc;
+    Receipts emptyReceipts; // receipts of a new tuple are a copy of it
+    Slot* slots;
+    size_t capacity; // number of slots, a power of two
+    size_t numberOfTuples;
 
     int getHashID (T1 key) override {
-        size_t hashedKey = hash<T1>()(key); // getting the hash of the object key
-        return hashedKey % szP; // compressing the hash value
+        return hash<T1>()(key) & (capacity - 1); // home slot of the key
     }
-public:
-    // constructor
-    HashTable() {
-        table = new List<pair<pair<T1, T2>, Set<string>>>  [szP];
+
+    Slot* allocateSlots(size_t count) {
+        Slot* result = Traits::allocate(alloc, count);
+        for (size_t i = 0; i < count; ++i)
+            result[i].distance = 0;
+        return result;
     }
 
     /*
-     * Check if a tuple <key, value, Set<T> exists.
-     * If yes:
-     *    1) use list's method add
-     *    2) insert in set string ID
-     * If no:
-     *    1) adding the tuple into the HashMap
-     *    2) insert in set string ID
+     * Time complexity: O(1) expected
+     * Slot of the key or nullptr.
      */
-    void put (T1 key, T2 value, string ID) override {
-        int index = getHashID(key);
+    Slot* find(const T1& key, size_t hashedKey) {
+        size_t mask = capacity - 1;
+        size_t index = hashedKey & mask;
+        for (unsigned distance = 1; slots[index].distance >= distance; ++distance) {
+            if (slots[index].hash == hashedKey && slots[index].tuple().key == key)
+                return slots + index;
+            index = (index + 1) & mask;
+        }
+        return nullptr;
+    }
 
-        bool flag = false;
+    /*
+     * Time complexity: O(1) expected
+     * Put the tuple, which is not in the table, into a free slot (see Robin Hood above)
+     * and return where it is now. The table must have a free slot.
+     */
+    Tuple* place(Tuple&& tuple, size_t hashedKey) {
+        size_t mask = capacity - 1;
+        size_t index = hashedKey & mask;
+        unsigned distance = 1;
+        Tuple* placed = nullptr; // the displaced tuples go on, the first one stays
+        while (true) {
+            Slot& slot = slots[index];
+            if (slot.distance == 0) {
+                TupleTraits::construct(tupleAlloc, &slot.tuple(), std::move(tuple));
+                slot.distance = distance;
+                slot.hash = hashedKey;
+                return placed != nullptr ? placed : &slot.tuple();
+            }
+            if (slot.distance < distance) { // the tuple of the slot is closer to its home
+                if (placed == nullptr)
+                    placed = &slot.tuple();
+                std::swap(tuple, slot.tuple());
+                std::swap(hashedKey, slot.hash);
+                std::swap(distance, slot.distance);
+            }
+            index = (index + 1) & mask;
+            distance++;
+        }
+    }
 
-        for (int i = 0; i < table[index].size(); ++i) {
-            if (table[index].get(i).first.first == key) {
-                table[index].add(i, value);
-                table[index].insertInSet(i, ID);
-                flag = true;
-                break;
+    /*
+     * Time complexity: O(N) worst case, amortized O(1) per put
+     * Double the number of slots and move all the tuples there.
+     */
+    void grow() {
+        Slot* oldSlots = slots;
+        size_t oldCapacity = capacity;
+
+        capacity *= 2;
+        slots = allocateSlots(capacity);
+        for (size_t i = 0; i < oldCapacity; ++i) {
+            if (oldSlots[i].distance != 0) {
+                place(std::move(oldSlots[i].tuple()), oldSlots[i].hash);
+                TupleTraits::destroy(tupleAlloc, &oldSlots[i].tuple());
             }
         }
-        if (!flag) {
-            table[index].push(make_pair(make_pair(key, value), Set<string>()));
-            table[index].insertInSet(table[index].size() - 1, ID);
+        Traits::deallocate(alloc, oldSlots, oldCapacity);
+    }
+public:
+    // constructor, a small table, it grows with the number of keys
+    explicit HashTable(const Alloc& alloc = Alloc()) : HashTable(alloc, Receipts(StringAlloc(alloc))) {}
+
+    // emptyReceipts sets up the receipts of every tuple, e.g. the precision of the sketches
+    HashTable(const Alloc& alloc, const Receipts& emptyReceipts)
+        : alloc(alloc), tupleAlloc(alloc), emptyReceipts(emptyReceipts) {
+        capacity = 16;
+        numberOfTuples = 0;
+        slots = allocateSlots(capacity);
+    }
+
+    HashTable(const HashTable&) = delete;
+    HashTable& operator=(const HashTable&) = delete;
+
+    ~HashTable() {
+        for (size_t i = 0; i < capacity; ++i) {
+            if (slots[i].distance != 0)
+                TupleTraits::destroy(tupleAlloc, &slots[i].tuple());
         }
+        Traits::deallocate(alloc, slots, capacity);
+    }
+
+    /*
+     * Time complexity: O(K) expected
+     * The tuple of the key, or a new tuple <key, 0, empty Set> if there is none.
+     * The key is copied only for a new tuple. The reference is valid until the next insertion.
+     */
+    Tuple& findOrInsert (const T1& key) {
+        size_t hashedKey = hash<T1>()(key);
+
+        Slot* slot = find(key, hashedKey);
+        if (slot != nullptr)
+            return slot->tuple();
+
+        if ((numberOfTuples + 1) * 8 > capacity * 7)
+            grow();
+
+        numberOfTuples++;
+        return *place(Tuple{key, T2(), Receipts(emptyReceipts)}, hashedKey);
+    }
+
+    /*
+     * Time complexity: O(K) expected
+     * The tuple of the key or nullptr, nothing is copied.
+     */
+    Tuple* lookup (const T1& key) {
+        Slot* slot = find(key, hash<T1>()(key));
+        return slot != nullptr ? &slot->tuple() : nullptr;
+    }
+
+    /*
+     * Time complexity: O(K) expected, plus the insert into the Set
+     * Find or add the tuple <key, value, Set<T>>, then
+     *    1) add value to its total
+     *    2) insert in set string ID
+     */
+    void put (T1 key, T2 value, string ID) override {
+        Tuple& tuple = findOrInsert(key);
+        tuple.value += value;
+        tuple.receipts.insert(std::move(ID));
     }
 
     /*
-     * get id of object key using getHashID method
+     * Time complexity: O(K) expected
      * Checking, if the tuple with key exists and
      * return the value.
      */
     T2 getValue (T1 key) override {
-        int index = getHashID(key);
-
-        for (int i = 0; i < table[index].size(); ++i) {
-            if (table[index].get(i).first.first == key) {
-                return table[index].get(i).first.second;
-            }
-        }
+        Tuple* tuple = lookup(key);
+        if (tuple != nullptr)
+            return tuple->value;
 
         cout << "There are no tuple with object " << key << endl;
         cout << "Method returned 0";
@@ -295,42 +886,237 @@ public:
     }
 
     /*
-     * Output all the tuples in the format <key, value, Set<T>.size()>
-     * I go through the entire array of lists, looking for all existing tuples
+     * Number of tuples, which are d slots away from their home slot, for every d.
+     * Robin Hood hashing keeps this distribution short: the mean is about 1-2 even at 7/8 load.
      */
-    void print () {
-        for (int i = 0; i < szP; ++i) {
-            if (table[i].size() != 0) {
-                for (int j = 0; j < table[i].size(); ++j) {
-                    cout << fixed << setprecision(2);
-                    cout << table[i].get(j).first.first << " $" << table[i].get(j).first.second << " " << table[i].getSetSizeFromList(j) << endl;
-                }
-            }
+    vector<long long> probeLengths() {
+        vector<long long> counts;
+        for (size_t i = 0; i < capacity; ++i) {
+            if (slots[i].distance == 0)
+                continue;
+            if (counts.size() < slots[i].distance)
+                counts.resize(slots[i].distance);
+            counts[slots[i].distance - 1]++;
         }
+        return counts;
+    }
 
+    size_t size() const {
+        return numberOfTuples;
     }
-};
 
-int main() {
-    int K; // number of input lines
-    cin >> K;
+    size_t slotCount() const {
+        return capacity;
+    }
 
+    /*
+     * Output all the tuples in the format <key, value, Set<T>.size()>
+     * I go through the slots of the table, looking for all existing tuples.
+     * Lines are formatted by the writer and written with one call in the end.
+     * Values are sums of prices, so rounding them to cents is exact.
+     */
+    void print (OutputWriter& out) {
+        for (size_t i = 0; i < capacity; ++i) {
+            if (slots[i].distance == 0)
+                continue;
+            Tuple& tuple = slots[i].tuple();
+            out.write(tuple.key);
+            out.write(" $");
+            out.writeCents(llround(tuple.value * 100));
+            out.write(' ');
+            out.writeInteger(tuple.receipts.size());
+            out.write('\n');
+        }
+        out.flush();
+    }
+};
+
+/*
+ * Read K lines, put them into the table and output the answer.
+ * Returns false (nothing is output) if a line can not be read.
+ * --probe-stats: distribution of the probe lengths of the table to stderr.
+ */
+template <typename Table>
+bool accountReceipts(Table& mp, long long K, bool probeStats) {
     string date, time, ID, cost, title;
     double doubleCost;
 
-    HashTable<string, double> mp;
-
-    while (K--) {
+    for (long long line = 1; line <= K; ++line) {
         cin >> date >> time >> ID >> cost;
         cin.ignore();
         getline(cin, title);
 
-        cost.erase(cost.begin()); // delete dollar sign
-        doubleCost = stod(cost); // cast string to double
+        // the stream fails at the end of the input, the cost must be $<number>
+        char* end = nullptr;
+        if (!cin.fail() && cost.size() >= 2 && cost[0] == '$')
+            doubleCost = strtod(cost.c_str() + 1, &end); // skip the dollar sign
+        if (end == nullptr || *end != '\0') {
+            cerr << "Can not read the receipt line " << line << " of " << K << endl;
+            return false;
+        }
+
+        // update the tuple in place, put would copy the date and the ID
+        auto& tuple = mp.findOrInsert(date);
+        tuple.value += doubleCost;
+        tuple.receipts.insert(std::move(ID));
+    }
+
+    OutputWriter out(stdout);
+    mp.print(out); // output the answer
+
+    if (probeStats) {
+        vector<long long> probes = mp.probeLengths();
+        long long total = 0;
+        for (size_t d = 0; d < probes.size(); ++d)
+            total += probes[d] * (d + 1);
+        cerr << mp.size() << " keys in " << mp.slotCount() << " slots, mean probe length "
+             << fixed << setprecision(2) << (double) total / max<size_t>(mp.size(), 1) << endl;
+        for (size_t d = 0; d < probes.size(); ++d)
+            cerr << "probe length " << d + 1 << ": " << probes[d] << endl;
+    }
+    return true;
+}
+
+/*
+ * Key with a chosen hash, hashTableSelfTest builds clusters of keys with it.
+ */
+struct ChosenHashKey {
+    int id;
+    size_t hash;
 
-        mp.put(date, doubleCost, ID);
+    bool operator==(const ChosenHashKey& other) const {
+        return id == other.id;
     }
+};
+
+ostream& operator<<(ostream& out, const ChosenHashKey& key) {
+    return out << key.id;
+}
+
+namespace std {
+    template <>
+    struct hash<ChosenHashKey> {
+        size_t operator()(const ChosenHashKey& key) const {
+            return key.hash;
+        }
+    };
+}
+
+/*
+ * Deterministic checks of the probe lengths of HashTable (main --self-test):
+ *  - distinct keys with the real hash: every key is counted, short probes at 7/8 load;
+ *  - keys with distinct home slots: every key is in its home slot, also after growing;
+ *  - keys with one home slot: one cluster, the probe lengths are exactly 1, 2, ..., K,
+ *    and every key is still found with its own value;
+ *  - a cluster which comes later: its keys displace the keys closer to their homes.
+ * Prints one line per check, returns 1 if a check fails.
+ */
+int hashTableSelfTest() {
+    bool failed = false;
+    auto check = [&](const char* title, bool ok) {
+        cout << title << ": " << (ok ? "OK" : "FAILED") << endl;
+        failed |= !ok;
+    };
 
-    mp.print(); // output the answer
+    {
+        HashTable<string, double> table;
+        const int keys = 100000;
+        for (int id = 0; id < keys; ++id)
+            table.put("2021-" + to_string(id), 1, "R");
+        vector<long long> probes = table.probeLengths();
+        long long count = 0, total = 0;
+        for (size_t d = 0; d < probes.size(); ++d) {
+            count += probes[d];
+            total += probes[d] * (d + 1);
+        }
+        check("real hash, every key counted", count == keys && (int) table.size() == keys);
+        check("real hash, mean probe length at most 3", total <= 3LL * keys);
+        check("real hash, longest probe at most 32", probes.size() <= 32);
+    }
+
+    {
+        HashTable<ChosenHashKey, double> table;
+        const int keys = 1000;
+        for (int id = keys - 1; id >= 0; --id)
+            table.put(ChosenHashKey{id, (size_t) id}, id, "R");
+        check("distinct homes, every key in its home slot", table.probeLengths() == vector<long long>{keys});
+    }
+
+    {
+        HashTable<ChosenHashKey, double> table;
+        const int keys = 100;
+        for (int id = 0; id < keys; ++id)
+            table.put(ChosenHashKey{id, 12345}, id, "R");
+        check("one cluster, probe lengths 1..K", table.probeLengths() == vector<long long>(keys, 1));
+
+        bool found = true;
+        for (int id = 0; id < keys; ++id)
+            found &= table.getValue(ChosenHashKey{id, 12345}) == id;
+        check("one cluster, every key found", found);
+    }
+
+    {
+        // 7 keys of home 1, then 7 keys of home 0 (the table does not grow yet):
+        // the later keys take the slots of the earlier ones, which are closer to home,
+        // so the homes get slots 0..6 and 7..13, probe lengths 1..7 and 7..13.
+        // Linear probing without Robin Hood would leave a probe of length 14.
+        HashTable<ChosenHashKey, double> table;
+        for (int id = 0; id < 14; ++id)
+            table.put(ChosenHashKey{id, (size_t) (id < 7 ? 1 : 0)}, id, "R");
+        vector<long long> expected(13, 1);
+        expected[6] = 2;
+        check("two clusters, Robin Hood evens the probe lengths", table.probeLengths() == expected);
+    }
+
+    return failed ? 1 : 0;
+}
+
+int main(int argc, char* argv[]) {
+    // --self-test: check the probe lengths of the table, see hashTableSelfTest
+    // --probe-stats: report the probe lengths of the table
+    // --approximate [p]: count the receipts with HyperLogLog sketches of 2^p registers
+    typedef HyperLogLog<string, ArenaAllocator<string>> Sketch;
+    bool probeStats = false;
+    bool approximate = false;
+    int precision = 12;
+    for (int i = 1; i < argc; ++i) {
+        if (string(argv[i]) == "--self-test") {
+            return hashTableSelfTest();
+        } else if (string(argv[i]) == "--probe-stats") {
+            probeStats = true;
+        } else if (string(argv[i]) == "--approximate") {
+            approximate = true;
+            if (i + 1 < argc && isdigit((unsigned char) argv[i + 1][0])) {
+                char* end;
+                long value = strtol(argv[++i], &end, 10);
+                if (*end != '\0' || value < Sketch::minPrecision || value > Sketch::maxPrecision) {
+                    cerr << "Precision of --approximate must be an integer from "
+                         << Sketch::minPrecision << " to " << Sketch::maxPrecision << ", got " << argv[i] << endl;
+                    return 1;
+                }
+                precision = (int) value;
+            }
+        }
+    }
+
+    long long K; // number of input lines, billions for the approximate mode
+    if (!(cin >> K) || K < 0) {
+        cerr << "Can not read the number of lines" << endl;
+        return 1;
+    }
+
+    // The whole input is processed in one arena, it is freed at once in the end
+    Arena arena;
+    if (!approximate) {
+        HashTable<string, double, ArenaAllocator<char>> mp{ArenaAllocator<char>(&arena)};
+        if (!accountReceipts(mp, K, probeStats))
+            return 1;
+    } else {
+        typedef HashTable<string, double, ArenaAllocator<char>, HyperLogLog> ApproximateTable;
+        ApproximateTable mp(ArenaAllocator<char>(&arena),
+                            Sketch(ArenaAllocator<string>(&arena), precision));
+        if (!accountReceipts(mp, K, probeStats))
+            return 1;
+    }
     return 0;
-}
\ No newline at end of file
+}